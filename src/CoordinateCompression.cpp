@@ -0,0 +1,105 @@
+#include "CoordinateCompression.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+	template<int index>
+	using value_t = std::remove_cvref_t<decltype(std::declval<const PSegment&>().getStart<index>())>;
+	template<int index>
+	using rank_t = std::remove_cvref_t<decltype(std::declval<const CSegment&>().getStart<index>())>;
+}
+
+CoordinateCompression::CoordinateCompression(const std::vector<const PSET*>& sets, const std::vector<PSegment>& extra){
+	util::constexpr_for<0,PSegment::dimensions,1>([&](auto dim){
+				auto& bounds = bounds_m[dim];
+				bounds.push_back(0);
+				auto add = [&bounds,dim](const PSegment& seg){
+					if(seg.empty())return;
+					bounds.push_back(seg.getStart<dim>());
+					if(seg.getEnd<dim>() != std::numeric_limits<value_t<dim>>::max()){
+						bounds.push_back(seg.getEnd<dim>()+1);
+					}
+				};
+				for(const auto* set : sets){
+					for(const auto& seg : set->segments)add(seg);
+				}
+				for(const auto& seg : extra)add(seg);
+				std::ranges::sort(bounds);
+				bounds.erase(std::unique(bounds.begin(),bounds.end()),bounds.end());
+				if(bounds.size()-1 > std::numeric_limits<rank_t<dim>>::max()){
+					throw std::length_error("too many interval boundaries to compress a dimension");
+				}
+				bounds.shrink_to_fit();
+			});
+}
+template<int index>
+auto CoordinateCompression::rank(uint64_t value) const -> uint64_t {
+	const auto& bounds = bounds_m[index];
+	return std::upper_bound(bounds.begin(),bounds.end(),value)-bounds.begin()-1;
+}
+template<int index>
+auto CoordinateCompression::end(uint64_t rank) const -> uint64_t {
+	const auto& bounds = bounds_m[index];
+	if(rank+1 >= bounds.size())return std::numeric_limits<value_t<index>>::max();
+	return bounds[rank+1]-1;
+}
+
+auto CoordinateCompression::compress(const PSegment& seg) const -> CSegment {
+	CSegment ret;
+	if(seg.empty())return CSegment(1,0);
+	util::constexpr_for<0,PSegment::dimensions,1>([&](auto dim){
+				ret.setInterval<dim>(
+						static_cast<rank_t<dim>>(rank<dim>(seg.getStart<dim>())),
+						static_cast<rank_t<dim>>(rank<dim>(seg.getEnd<dim>())));
+			});
+	return ret;
+}
+auto CoordinateCompression::compress(const PSET& set) const -> CSET {
+	bor::vector<CSegment> segments;
+	segments.reserve(set.segments.size());
+	for(const auto& seg : set.segments)segments.push_back(compress(seg));
+	return CSET(std::move(segments));
+}
+auto CoordinateCompression::decompress(const CSegment& seg) const -> PSegment {
+	PSegment ret;
+	if(seg.empty())return PSegment(1,0);
+	util::constexpr_for<0,PSegment::dimensions,1>([&](auto dim){
+				ret.setInterval<dim>(
+						static_cast<value_t<dim>>(start<dim>(seg.getStart<dim>())),
+						static_cast<value_t<dim>>(end<dim>(seg.getEnd<dim>())));
+			});
+	return ret;
+}
+auto CoordinateCompression::decompress(const CSET& set) const -> PSET {
+	bor::vector<PSegment> segments;
+	segments.reserve(set.segments.size());
+	for(const auto& seg : set.segments)segments.push_back(decompress(seg));
+	return PSET(std::move(segments));
+}
+auto CoordinateCompression::getAmountPoints(const CSET& set) const -> long double {
+	long double ret = 0;
+	for(const auto& seg : set.segments){
+		if(seg.empty())continue;
+		long double points = 1;
+		util::constexpr_for<0,PSegment::dimensions,1>([&](auto dim){
+					points *= end<dim>(seg.getEnd<dim>())-(long double)start<dim>(seg.getStart<dim>())+1;
+				});
+		ret += points;
+	}
+	return ret;
+}
+
+template auto CoordinateCompression::rank<PSegment::SRC_IP_INDEX>(uint64_t) const -> uint64_t;
+template auto CoordinateCompression::rank<PSegment::DST_IP_INDEX>(uint64_t) const -> uint64_t;
+template auto CoordinateCompression::rank<PSegment::SRC_PORT_INDEX>(uint64_t) const -> uint64_t;
+template auto CoordinateCompression::rank<PSegment::DST_PORT_INDEX>(uint64_t) const -> uint64_t;
+template auto CoordinateCompression::rank<PSegment::IN_INTERFACE_INDEX>(uint64_t) const -> uint64_t;
+template auto CoordinateCompression::rank<PSegment::OUT_INTERFACE_INDEX>(uint64_t) const -> uint64_t;
+template auto CoordinateCompression::rank<PSegment::PROTOCOL_INDEX>(uint64_t) const -> uint64_t;
+template auto CoordinateCompression::end<PSegment::SRC_IP_INDEX>(uint64_t) const -> uint64_t;
+template auto CoordinateCompression::end<PSegment::DST_IP_INDEX>(uint64_t) const -> uint64_t;
+template auto CoordinateCompression::end<PSegment::SRC_PORT_INDEX>(uint64_t) const -> uint64_t;
+template auto CoordinateCompression::end<PSegment::DST_PORT_INDEX>(uint64_t) const -> uint64_t;
+template auto CoordinateCompression::end<PSegment::IN_INTERFACE_INDEX>(uint64_t) const -> uint64_t;
+template auto CoordinateCompression::end<PSegment::OUT_INTERFACE_INDEX>(uint64_t) const -> uint64_t;
+template auto CoordinateCompression::end<PSegment::PROTOCOL_INDEX>(uint64_t) const -> uint64_t;
@@ -0,0 +1,65 @@
+#pragma once
+#include "SegmentSet.hpp"
+#include <array>
+#include <vector>
+#include <cstdint>
+
+/**
+ * @brief maps the values of every dimension of PSegment to the ranks of elementary intervals
+ * @details a ruleset only references a few thousand distinct interval boundaries per dimension\n
+ * the boundaries of all given segments split every dimension into elementary intervals,\n
+ * which are numbered in ascending order, so a value is replaced by the rank of its interval\n
+ * every interval of the given segments is a contiguous range of ranks, therefore set operations\n
+ * on compressed sets yield the compression of the results on the original sets\n
+ * compressed sets must only contain valid ranks, so they mustn't be negated on their own\n
+ * in the following complexity descriptions:
+ * - @b b denotes the amount of boundaries of a dimension
+ * - @b n denotes the amount of segments of a set
+ */
+class CoordinateCompression {
+public:
+	/**
+	 * collects the boundaries of the segments of sets and of extra\n
+	 * runtime O(n*log(n)) for all segments
+	 * @throws std::length_error if the ranks of a dimension don't fit into CSegment
+	 */
+	CoordinateCompression(const std::vector<const PSET*>& sets, const std::vector<PSegment>& extra = {});
+
+	//!@returns the amount of ranks of dimension index
+	template<int index>
+	auto ranks() const -> size_t {
+		return bounds_m[index].size();
+	}
+	/**
+	 * @returns the rank of the interval containing value\n
+	 * runtime O(log(b))
+	 */
+	template<int index>
+	auto rank(uint64_t value) const -> uint64_t;
+	//!@returns the first value of the interval with rank
+	template<int index>
+	auto start(uint64_t rank) const -> uint64_t {
+		return bounds_m[index][rank];
+	}
+	//!@returns the last value of the interval with rank
+	template<int index>
+	auto end(uint64_t rank) const -> uint64_t;
+
+	/**
+	 * only exact if the boundaries of seg were collected\n
+	 * otherwise the intervals are extended to the enclosing elementary intervals
+	 */
+	auto compress(const PSegment& seg) const -> CSegment;
+	auto compress(const PSET& set) const -> CSET;
+	auto decompress(const CSegment& seg) const -> PSegment;
+	auto decompress(const CSET& set) const -> PSET;
+	/**
+	 * @returns the amount of packets the segments of set represent\n
+	 * like PSET::getAmountPoints overlapping segments are counted multiple times\n
+	 * runtime O(n)
+	 */
+	auto getAmountPoints(const CSET& set) const -> long double;
+private:
+	//!starts of the elementary intervals of every dimension in ascending order, beginning with 0
+	std::array<std::vector<uint32_t>,PSegment::dimensions> bounds_m;
+};
@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+#include <rapidcheck/gtest.h>
+#include <stdexcept>
+#include <cmath>
+#include "CoordinateCompression.hpp"
+#include "SegmentSet-generator.hpp"
+
+TEST(CoordinateCompression,ranks_of_boundaries){
+	PSegment seg1, seg2;
+	seg1.setInterval<PSegment::DST_PORT_INDEX>(10,19);
+	seg2.setInterval<PSegment::DST_PORT_INDEX>(15,65535);
+	PSET set{{seg1,seg2}};
+	CoordinateCompression compression({&set});
+	//0-9, 10-14, 15-19 and 20-65535
+	EXPECT_EQ(compression.ranks<PSegment::DST_PORT_INDEX>(),4);
+	EXPECT_EQ(compression.ranks<PSegment::SRC_PORT_INDEX>(),1);
+	EXPECT_EQ(compression.rank<PSegment::DST_PORT_INDEX>(12),1);
+	EXPECT_EQ(compression.start<PSegment::DST_PORT_INDEX>(2),15);
+	EXPECT_EQ(compression.end<PSegment::DST_PORT_INDEX>(2),19);
+	EXPECT_EQ(compression.end<PSegment::DST_PORT_INDEX>(3),65535);
+
+	auto compressed = compression.compress(seg1);
+	EXPECT_EQ(compressed.getStart<PSegment::DST_PORT_INDEX>(),1);
+	EXPECT_EQ(compressed.getEnd<PSegment::DST_PORT_INDEX>(),2);
+	EXPECT_EQ(compressed.getEnd<PSegment::SRC_IP_INDEX>(),0);
+	EXPECT_EQ(compression.decompress(compressed),seg1);
+}
+TEST(CoordinateCompression,too_many_boundaries){
+	std::vector<PSegment> segments;
+	for(uint32_t i = 0; i < 40000; ++i){
+		segments.emplace_back().setInterval<PSegment::SRC_IP_INDEX>(4*i,4*i+1);
+	}
+	EXPECT_THROW(CoordinateCompression({},segments),std::length_error);
+	segments.resize(30000);
+	EXPECT_EQ(CoordinateCompression({},segments).ranks<PSegment::SRC_IP_INDEX>(),60000);
+}
+RC_GTEST_PROP(CoordinateCompression,round_trip,(const PSET& set)){
+	CoordinateCompression compression({&set});
+	auto compressed = compression.compress(set);
+	RC_ASSERT(compression.decompress(compressed).segments == set.segments);
+	//the widths are multiplied in another order
+	auto points = set.getAmountPoints();
+	RC_ASSERT(std::abs(compression.getAmountPoints(compressed)-points) <= points*1e-12L);
+}
+RC_GTEST_PROP(CoordinateCompression,operations_equal_to_PSET,(const PSET& all1, const PSET& all2)){
+	//canonicalizing random sets dominates the runtime
+	auto set1 = all1, set2 = all2;
+	if(set1.segments.size() > 8)set1.segments.resize(8);
+	if(set2.segments.size() > 8)set2.segments.resize(8);
+	CoordinateCompression compression({&set1,&set2});
+	auto check = [&](auto&& op){
+		auto set = set1;
+		op(set,set2);
+		set.canonicalize();
+		auto compressed = compression.compress(set1);
+		op(compressed,compression.compress(set2));
+		auto result = compression.decompress(compressed);
+		result.canonicalize();
+		RC_ASSERT(result == set);
+	};
+	check([](auto& s1, const auto& s2){s1.UNION(s2);});
+	check([](auto& s1, const auto& s2){s1.INTERSECTION(s2);});
+	check([](auto& s1, const auto& s2){s1.INTERSECTION_NEGATED(s2);});
+	RC_ASSERT(compression.compress(set1).intersects(compression.compress(set2)) == set1.intersects(set2));
+	RC_ASSERT(compression.compress(set1).isSubsetOf(compression.compress(set2)) == set1.isSubsetOf(set2));
+}
@@ -1,6 +1,8 @@
 #include "IpAnalyzer.hpp"
 #include "log.hpp"
 #include "args.hpp"
+#include "spill.hpp"
+#include "memory_resource.hpp"
 #include <tabulate/tabulate.hpp>
 
 #include <set>
@@ -8,25 +10,201 @@
 #include <cassert>
 #include <ranges>
 #include <algorithm>
+#include <utility>
+namespace {
+	//!rows of a chain that are analyzed by the same thread
+	constexpr size_t rows_per_block = 64;
+	/**
+	 * calls find(rules,i) for every row i of every chain of ruleset\n
+	 * chains and blocks of rows of large chains are distributed dynamically over args::regionThreads() threads\n
+	 * @return the pairs returned by find in the order of tables, chains and rows independent of the scheduling
+	 */
+	template<typename F>
+	auto findRulePairs(Ruleset& ruleset, F&& find) -> std::vector<std::pair<Rule*,Rule*>> {
+		struct block_t {
+			std::vector<Rule>* rules;
+			size_t begin, end;
+		};
+		std::vector<block_t> blocks;
+		for(auto& table : ruleset.tables){
+			for(auto& chain : table.chains){
+				auto& rules = chain->rules;
+				for(size_t begin = 0; begin < rules.size(); begin += rows_per_block){
+					blocks.push_back({&rules,begin,std::min(begin+rows_per_block,rules.size())});
+				}
+			}
+		}
+		std::vector<std::vector<std::pair<Rule*,Rule*>>> partial(blocks.size());
+#pragma omp parallel for schedule(dynamic,1) num_threads(args::regionThreads())
+		for(size_t b = 0; b < blocks.size(); ++b){
+			auto& rules = *blocks[b].rules;
+			for(size_t i = blocks[b].begin; i < blocks[b].end; ++i){
+				if(rules[i].shouldBeIgnored)continue;
+				if(auto pair = find(rules,i)){
+					partial[b].push_back(*pair);
+				}
+			}
+		}
+		std::vector<std::pair<Rule*,Rule*>> ret;
+		for(auto& p : partial){
+			ret.insert(ret.end(),p.begin(),p.end());
+		}
+		return ret;
+	}
+	/**
+	 * @brief compares the maximumMatchingSets of rules\n
+	 * as bitsets of packet classes, if there are classes
+	 */
+	struct matching_sets_t {
+		const PacketPartition* classes;
+		bool intersects(const Rule& r1, const Rule& r2) const {
+			if(classes)return classes->predicate(r1.id).intersects(classes->predicate(r2.id));
+			return r1.maximumMatchingSet.intersects(r2.maximumMatchingSet);
+		}
+		bool isSubsetOf(const Rule& r1, const Rule& r2) const {
+			if(classes)return classes->predicate(r1.id).isSubsetOf(classes->predicate(r2.id));
+			return r1.maximumMatchingSet.isSubsetOf(r2.maximumMatchingSet);
+		}
+	};
+	//!@returns Rule::maximumMatchingSet as set_t
+	template<typename set_t>
+	auto matchingSet(const auto& run, const Rule& rule) -> const set_t& {
+		if constexpr(std::is_same_v<set_t,PSET>){
+			return rule.maximumMatchingSet;
+		}else{
+			return run.matching_sets[rule.id];
+		}
+	}
+	/**
+	 * replaces the destination (DNAT) or source (SNAT) of the packets in match with the one of Rule::nat\n
+	 * without a port change SNAT keeps source ports in the ranges 0-511, 512-1023 and 1024-65535
+	 */
+	void translate(PSET& match, const Rule& rule){
+		const auto& transform = *rule.nat;
+		bool dnat = rule.jumpTarget->special == Chain::Special::DNAT;
+		for(auto& seg : match.segments){
+			if(dnat){
+				seg.setInterval<PSegment::DST_IP_INDEX>(
+						transform.start_ip,
+						transform.end_ip);
+				if(transform.has_port_change){
+					seg.setInterval<PSegment::DST_PORT_INDEX>(
+						transform.start_port,
+						transform.end_port);
+				}
+				continue;
+			}
+			seg.setInterval<PSegment::SRC_IP_INDEX>(
+					transform.start_ip,
+					transform.end_ip);
+			if(transform.has_port_change){
+				seg.setInterval<PSegment::SRC_PORT_INDEX>(
+					transform.start_port,
+					transform.end_port);
+			}else{
+				auto& p_start = seg.getStart<PSegment::SRC_PORT_INDEX>();
+				auto& p_end = seg.getEnd<PSegment::SRC_PORT_INDEX>();
+				if(p_start <= 511)p_start = 0;
+				else if(p_start <= 1023)p_start = 512;
+				else p_start = 1024;
+				if(p_end >= 1024)p_end = std::numeric_limits<std::remove_reference_t<decltype(p_end)>>::max();
+				else if(p_end >= 512)p_end = 1023;
+				else p_end = 511;
+			}
+		}
+		match.modified();
+		match.compact(CompactionPolicy::budget(args::config.compaction));
+	}
+	void translate(PacketBDD& match, const Rule& rule){
+		const auto& transform = *rule.nat;
+		bool dnat = rule.jumpTarget->special == Chain::Special::DNAT;
+		if(dnat){
+			match.setInterval<PSegment::DST_IP_INDEX>(transform.start_ip,transform.end_ip);
+			if(transform.has_port_change){
+				match.setInterval<PSegment::DST_PORT_INDEX>(transform.start_port,transform.end_port);
+			}
+			return;
+		}
+		match.setInterval<PSegment::SRC_IP_INDEX>(transform.start_ip,transform.end_ip);
+		if(transform.has_port_change){
+			match.setInterval<PSegment::SRC_PORT_INDEX>(transform.start_port,transform.end_port);
+			return;
+		}
+		PacketBDD translated;
+		for(auto [start,end] : {std::pair{0,511},std::pair{512,1023},std::pair{1024,65535}}){
+			auto ports = match;
+			ports.INTERSECTION(PacketBDD::range<PSegment::SRC_PORT_INDEX>(start,end));
+			ports.setInterval<PSegment::SRC_PORT_INDEX>(start,end);
+			translated.UNION(ports);
+		}
+		match = translated;
+	}
+	//!the images of the classes were computed with the partition
+	void translate(PacketClasses& match, const Rule& rule){
+		match = match.partition()->translate(match,rule.id);
+	}
+	//!translate(PSET&,const Rule&) on the ranks of compression, which contains the boundaries of Rule::nat
+	void translate(CSET& match, const Rule& rule, const CoordinateCompression& compression){
+		constexpr int SRC_PORT = PSegment::SRC_PORT_INDEX;
+		const auto& transform = *rule.nat;
+		bool dnat = rule.jumpTarget->special == Chain::Special::DNAT;
+		for(auto& seg : match.segments){
+			if(dnat){
+				seg.setInterval<PSegment::DST_IP_INDEX>(
+						compression.rank<PSegment::DST_IP_INDEX>(transform.start_ip),
+						compression.rank<PSegment::DST_IP_INDEX>(transform.end_ip));
+				if(transform.has_port_change){
+					seg.setInterval<PSegment::DST_PORT_INDEX>(
+						compression.rank<PSegment::DST_PORT_INDEX>(transform.start_port),
+						compression.rank<PSegment::DST_PORT_INDEX>(transform.end_port));
+				}
+				continue;
+			}
+			seg.setInterval<PSegment::SRC_IP_INDEX>(
+					compression.rank<PSegment::SRC_IP_INDEX>(transform.start_ip),
+					compression.rank<PSegment::SRC_IP_INDEX>(transform.end_ip));
+			if(transform.has_port_change){
+				seg.setInterval<SRC_PORT>(
+					compression.rank<SRC_PORT>(transform.start_port),
+					compression.rank<SRC_PORT>(transform.end_port));
+			}else{
+				auto p_start = compression.start<SRC_PORT>(seg.getStart<SRC_PORT>());
+				auto p_end = compression.end<SRC_PORT>(seg.getEnd<SRC_PORT>());
+				if(p_start <= 511)p_start = 0;
+				else if(p_start <= 1023)p_start = 512;
+				else p_start = 1024;
+				if(p_end >= 1024)p_end = std::numeric_limits<uint16_t>::max();
+				else if(p_end >= 512)p_end = 1023;
+				else p_end = 511;
+				seg.setInterval<SRC_PORT>(compression.rank<SRC_PORT>(p_start),compression.rank<SRC_PORT>(p_end));
+			}
+		}
+		match.modified();
+		match.compact(CompactionPolicy::budget<CSegment>(args::config.compaction));
+	}
+	//!@returns the amount of packets in set, ranks are weighted by the widths of their intervals
+	template<typename set_t>
+	auto amountPoints(const auto& run, const set_t& set) -> long double {
+		if constexpr(std::is_same_v<set_t,CSET>){
+			return run.compression->getAmountPoints(set);
+		}else{
+			return set.getAmountPoints();
+		}
+	}
+}
 void IpAnalyzer::findMergeableRules(){
 	mlog::info("BEGINN MERGEABLE-RULE ANALYSIS\n");
-	for(auto& table : ruleset_m.tables){
-		for(auto& chain : table.chains){
-			auto& rules = chain->rules;
-			for(size_t i = 0; i < rules.size(); ++i){
-				if(rules[i].shouldBeIgnored)continue;
+	matching_sets_t sets{args::engine == args::Engine::CLASSES ? packetClasses() : nullptr};
+	mergeable_rule_results.rules = findRulePairs(ruleset_m,[sets](std::vector<Rule>& rules, size_t i) -> std::optional<std::pair<Rule*,Rule*>> {
 				for(size_t j = i+1; j < rules.size(); ++j){
 					if(rules[j].shouldBeIgnored)continue;
-					auto intersection = INTERSECTION(rules[i].maximumMatchingSet,rules[j].maximumMatchingSet);
 					if(mergeable(rules[i],rules[j])){
-						mergeable_rule_results.rules.emplace_back(&rules[i],&rules[j]);
-						break;
+						return std::pair{&rules[i],&rules[j]};
 					}
-					if(!intersection.isEmpty())break;
+					if(sets.intersects(rules[i],rules[j]))break;
 				}
-			}
-		}
-	}
+				return std::nullopt;
+			});
 	std::ranges::sort(mergeable_rule_results.rules,[](const auto& p1, const auto& p2){
 				return p1.first->line < p2.first->line;
 			});
@@ -40,23 +218,18 @@ void IpAnalyzer::findMergeableRules(){
 
 void IpAnalyzer::findSubsetRules(){
 	mlog::info("BEGINN SUBSET-RULE ANALYSIS\n");
-	for(auto& table : ruleset_m.tables){
-		for(auto& chain : table.chains){
-			auto& rules = chain->rules;
-			for(size_t i = 0; i < rules.size(); ++i){
-				if(rules[i].shouldBeIgnored)continue;
+	matching_sets_t sets{args::engine == args::Engine::CLASSES ? packetClasses() : nullptr};
+	subset_rule_results.rules = findRulePairs(ruleset_m,[sets](std::vector<Rule>& rules, size_t i) -> std::optional<std::pair<Rule*,Rule*>> {
 				for(size_t j = i+1; j < rules.size(); ++j){
 					if(rules[j].shouldBeIgnored)continue;
-					auto intersection = INTERSECTION(rules[i].maximumMatchingSet,rules[j].maximumMatchingSet);
-					if(rules[j].jumpTarget == rules[i].jumpTarget && intersection == rules[i].maximumMatchingSet){
-						subset_rule_results.rules.emplace_back(&rules[i],&rules[j]);
-						break;
+					//an empty set is a subset of the next rule with the same target, although it intersects none
+					if(rules[j].jumpTarget == rules[i].jumpTarget && sets.isSubsetOf(rules[i],rules[j])){
+						return std::pair{&rules[i],&rules[j]};
 					}
-					if(!intersection.isEmpty())break;
+					if(sets.intersects(rules[i],rules[j]))break;
 				}
-			}
-		}
-	}
+				return std::nullopt;
+			});
 	std::ranges::sort(subset_rule_results.rules,[](const auto& p1, const auto& p2){
 				return p1.first->line < p2.first->line;
 			});
@@ -68,14 +241,230 @@ void IpAnalyzer::findSubsetRules(){
 	mlog::success("DONE SUBSET-RULE ANALYSIS\n");
 }
 IpAnalyzer::IpAnalyzer(Ruleset&& ruleset) : ruleset_m(std::forward<decltype(ruleset_m)>(ruleset))
+{
+	const auto max_canonical = args::config.canonicalize.max_segments;
+	//rules matching the same ipset share the storage of their set, it is prepared once for all of them
+	//the original is kept, so its storage can't be reused by another set while it is a key
+	std::unordered_map<const PSegment*,std::pair<PSET,PSET>> prepared;
+	//maximumMatchingSets don't change during the analysis
+	ruleset_m.forEachRule([&](Rule& rule){
+				rule.id = rule_count_m++;
+				auto& set = rule.maximumMatchingSet;
+				const PSegment* storage = set.segments.sharesStorage() ? std::as_const(set.segments).data() : nullptr;
+				if(storage != nullptr){
+					if(auto iter = prepared.find(storage); iter != std::end(prepared)){
+						set = iter->second.second;
+						return;
+					}
+				}
+				PSET original = storage != nullptr ? set : PSET();
+				if(set.segments.size() <= max_canonical){
+					set.canonicalize();
+				}
+				set.segments.shrink_to_fit();
+				if(set.segments.size() >= PSET::index_threshold){
+					set.buildIndex();
+				}
+				if(storage != nullptr){
+					prepared.emplace(storage,std::pair{std::move(original),set});
+				}
+			});
+}
+
+CompactionPolicy::CompactionPolicy(const config_t::compaction_t& config, size_t initial_size) :
+	config(config),
+	reference_size(initial_size)
 {}
+template<typename segment_t>
+auto CompactionPolicy::budget(const config_t::compaction_t& config) -> typename SegmentSet<segment_t>::compact_budget {
+	return {
+		.max_passes = config.max_passes,
+		.max_time = std::chrono::milliseconds(config.max_time_ms)
+	};
+}
+template<typename segment_t>
+auto CompactionPolicy::update(SegmentSet<segment_t>& set) -> std::optional<std::chrono::milliseconds> {
+	auto size = set.segments.size();
+	reference_size = std::min(reference_size,size);
+	if(size < config.min_segments || size < config.growth_ratio*reference_size){
+		return std::nullopt;
+	}
+	auto begin = std::chrono::steady_clock::now();
+	set.compact(budget<segment_t>(config));
+	reference_size = set.segments.size();
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now()-begin);
+}
+template auto CompactionPolicy::budget<PSegment>(const config_t::compaction_t&) -> PSET::compact_budget;
+template auto CompactionPolicy::budget<CSegment>(const config_t::compaction_t&) -> CSET::compact_budget;
+template auto CompactionPolicy::update<PSegment>(PSET&) -> std::optional<std::chrono::milliseconds>;
+template auto CompactionPolicy::update<CSegment>(CSET&) -> std::optional<std::chrono::milliseconds>;
 
-IpAnalyzer::PipeResult IpAnalyzer::pipeChain(Chain& chain, PSET try_match){
+template<typename set_t>
+auto IpAnalyzer::makeRun() const -> pipe_run_t<set_t> {
+	pipe_run_t<set_t> run;
+	run.counters.resize(rule_count_m);
+	if constexpr(std::is_same_v<set_t,PacketClasses>){
+		run.matching_sets.resize(rule_count_m);
+		for(size_t id = 0; id < rule_count_m; ++id){
+			run.matching_sets[id] = partition_m->predicate(id);
+		}
+	}else if constexpr(std::is_same_v<set_t,CSET>){
+		run.matching_sets = compressed_sets_m;
+		run.compression = compression_m.get();
+	}else if constexpr(std::is_same_v<set_t,PacketBDD>){
+		run.matching_sets.resize(rule_count_m);
+		for(const auto& table : ruleset_m.tables){
+			for(const auto& chain : table.chains){
+				for(const auto& rule : chain->rules){
+					run.matching_sets[rule.id] = set_t(rule.maximumMatchingSet);
+				}
+			}
+		}
+	}
+	return run;
+}
+auto IpAnalyzer::reachableRules(pipe_cache_t& cache, const Chain& chain) -> const std::vector<size_t>& {
+	if(auto iter = cache.reachable.find(&chain); iter != std::end(cache.reachable)){
+		return iter->second;
+	}
+	std::vector<size_t> ids;
+	std::set<const Chain*> visited;
+	std::function<void(const Chain&)> dfs = [&](const Chain& node){
+		if(!visited.insert(&node).second)return;
+		for(const auto& rule : node.rules){
+			ids.push_back(rule.id);
+			if(rule.jumpTarget != nullptr)dfs(*rule.jumpTarget);
+		}
+	};
+	dfs(chain);
+	return cache.reachable[&chain] = std::move(ids);
+}
+auto IpAnalyzer::pipeChain(pipe_run_t<PSET>& run, Chain& chain, PSET try_match) -> PipeResult<PSET> {
+	const auto& config = args::config.pipe_cache;
+	auto& cache = run.cache;
+	if(!config.enabled
+			|| chain.special != Chain::Special::NONE
+			|| try_match.segments.size() > config.max_input_segments){
+		return pipeChain_uncached(run,chain,std::move(try_match));
+	}
+	//try_match may live in the arena of the calling chain, the entry outlives it
+	bor::resource_scope heap_scope(bor::heap_resource());
+	//entries are keyed on their sorted input, which is cheap to compute,
+	//the canonical form is only computed once a chain is piped again and its sorted input misses
+	auto sorted = [](const PSET& set){
+		bor::vector<PSegment> segments = set.segments;
+		std::sort(segments.begin(),segments.end());
+		return PSET(std::move(segments));
+	};
+	auto keyOf = [&chain](const PSET& input){
+		return input.hash() ^ std::hash<const Chain*>{}(&chain);
+	};
+	auto find = [&](const PSET& input, std::optional<PackedSegments<PSegment>>& packed_input) -> const pipe_cache_t::entry_t* {
+		auto [begin,end] = cache.entries.equal_range(keyOf(input));
+		for(auto iter = begin; iter != end; ++iter){
+			const auto& entry = iter->second;
+			if(entry.chain != &chain || entry.input.size() != input.segments.size())continue;
+			if(!packed_input)packed_input = input.pack(PackedSegments<PSegment>::Encoding::DELTA);
+			if(entry.input == *packed_input)return &entry;
+		}
+		return nullptr;
+	};
+	//the canonical form can have more segments than try_match, so it is only used as key
+	PSET key_input = sorted(try_match);
+	std::optional<PackedSegments<PSegment>> packed_input;
+	const bool piped_before = !cache.piped.insert(&chain).second;
+	const pipe_cache_t::entry_t* entry = nullptr;
+	if(piped_before){
+		entry = find(key_input,packed_input);
+	}
+	if(piped_before && entry == nullptr){
+		PSET canonical = try_match;
+		canonical.canonicalize();
+		canonical = sorted(canonical);
+		if(!std::ranges::equal(canonical.segments,key_input.segments)){
+			key_input = std::move(canonical);
+			packed_input.reset();
+			entry = find(key_input,packed_input);
+		}
+	}
+	if(entry != nullptr){
+		cache.hits++;
+		run.accepted.UNION(PSET::unpack(entry->accepted));
+		for(const auto& [id,delta] : entry->counters){
+			auto& counters = run.counters[id];
+			counters.touched |= delta.touched;
+			counters.matched += delta.matched;
+			counters.aliveMatch += delta.aliveMatch;
+			counters.deadMatch += delta.deadMatch;
+			counters.aliveJump += delta.aliveJump;
+			counters.deadJump += delta.deadJump;
+		}
+		if(step_cost_m && run.progress){
+			run.cur_steps += step_cost_m->cost[&chain];
+		}
+		return {entry->something_accepted,PSET::unpack(entry->not_matched)};
+	}
+	cache.misses++;
+	//once the cache is full it is still read, but no entries are added
+	if(cache.memory >= config.max_memory_mb*1024*1024){
+		return pipeChain_uncached(run,chain,std::move(try_match));
+	}
+
+	const auto& reachable = reachableRules(cache,chain);
+	std::vector<Rule::counters_t> before;
+	before.reserve(reachable.size());
+	for(auto id : reachable)before.push_back(run.counters[id]);
+	auto prev_accepted = std::move(run.accepted);
+	run.accepted = PSET();
+
+	auto result = pipeChain_uncached(run,chain,std::move(try_match));
+	pipe_cache_t::entry_t new_entry{
+		&chain,
+		packed_input ? std::move(*packed_input) : key_input.pack(PackedSegments<PSegment>::Encoding::DELTA),
+		result.somethingAccepted,
+		result.not_matched.pack(PackedSegments<PSegment>::Encoding::DELTA),
+		run.accepted.pack(PackedSegments<PSegment>::Encoding::DELTA),
+		{}
+	};
+
+	prev_accepted.UNION(run.accepted);
+	run.accepted = std::move(prev_accepted);
+	for(size_t i = 0; i < reachable.size(); ++i){
+		const auto& after = run.counters[reachable[i]];
+		if(after == before[i])continue;
+		Rule::counters_t delta;
+		delta.touched = after.touched;
+		delta.matched = after.matched-before[i].matched;
+		delta.aliveMatch = after.aliveMatch-before[i].aliveMatch;
+		delta.deadMatch = after.deadMatch-before[i].deadMatch;
+		delta.aliveJump = after.aliveJump-before[i].aliveJump;
+		delta.deadJump = after.deadJump-before[i].deadJump;
+		new_entry.counters.emplace_back(reachable[i],delta);
+	}
+	size_t segment_bytes = new_entry.input.bytes()+new_entry.not_matched.bytes()+new_entry.accepted.bytes();
+	cache.memory += sizeof(new_entry) + segment_bytes + util::getMemoryUsage_raw(new_entry.counters);
+	cache.segments += new_entry.input.size()+new_entry.not_matched.size()+new_entry.accepted.size();
+	cache.segment_bytes += segment_bytes;
+	cache.entries.emplace(keyOf(key_input),std::move(new_entry));
+	return result;
+}
+template<typename set_t>
+auto IpAnalyzer::pipeChain(pipe_run_t<set_t>& run, Chain& chain, set_t try_match) -> PipeResult<set_t> {
+	return pipeChain_uncached(run,chain,std::move(try_match));
+}
+template<typename set_t>
+auto IpAnalyzer::pipeChain_uncached(pipe_run_t<set_t>& run, Chain& chain, set_t input) -> PipeResult<set_t> {
+	constexpr bool segments = std::is_same_v<set_t,PSET> || std::is_same_v<set_t,CSET>;
+	//the packets passed from rule to rule are kept on the heap,
+	//everything a single rule allocates is taken from an arena that is reset for the next rule
+	bor::resource_scope chain_scope(bor::heap_resource());
+	set_t try_match;
+	try_match = std::move(input);
 	switch(chain.special){
 		case Chain::Special::RETURN:
 			 throw std::runtime_error("return shouldnt be piped");
 		case Chain::Special::ACCEPT:
-			  accepted.UNION(try_match);
+			  run.accepted.UNION(try_match);
 			  [[fallthrough]];
 		case Chain::Special::DROP:
 			  [[fallthrough]];
@@ -84,95 +473,83 @@ IpAnalyzer::PipeResult IpAnalyzer::pipeChain(Chain& chain, PSET try_match){
 		default:
 			  break;
 	}
-	IpAnalyzer::PipeResult ret;
+	PipeResult<set_t> ret;
+	//PacketBDDs and PacketClasses don't fragment
+	std::optional<CompactionPolicy> compaction;
+	if constexpr(segments){
+		compaction.emplace(args::config.compaction,try_match.segments.size());
+	}
+	bor::arena arena;
 	for(auto& rule : chain.rules){
-		cur_steps++;
+		arena.reset();
+		bor::resource_scope rule_scope(arena);
+		run.cur_steps++;
+		if constexpr(segments){
+			auto prev_size = try_match.segments.size();
+			if(auto time = compaction->update(try_match); time && run.progress){
+				mlog::log("compacted {} -> {} segments in {}ms\n",prev_size,try_match.segments.size(),time->count());
+			}
+		}
 		if(rule.shouldBeIgnored){
-			if(step_cost_m && args::progress){
-				cur_steps += step_cost_m->cost[rule.jumpTarget];
+			if(step_cost_m && run.progress){
+				run.cur_steps += step_cost_m->cost[rule.jumpTarget];
 			}
 			continue;
 		}
-		rule.touched = true;
-		if(args::progress){
+		auto& counters = run.counters[rule.id];
+		counters.touched = true;
+		if(run.progress){
 			mlog::log("starting ({}): {}\n",rule.line,rule.line_str);
-			mlog::debug("input size {} ^= {}\n", try_match.segments.size(), util::getMemoryUsage(try_match.segments));
+			if constexpr(segments){
+				mlog::debug("input size {} ^= {}\n", try_match.segments.size(), util::getMemoryUsage(try_match.segments));
+			}else if constexpr(std::is_same_v<set_t,PacketBDD>){
+				mlog::debug("input size {} nodes\n", try_match.nodes());
+			}else{
+				mlog::debug("input size {} classes\n", try_match.count());
+			}
 		}
 		std::cout << std::flush;
 
-		auto match = INTERSECTION(rule.maximumMatchingSet,try_match);
-		if(match.isEmpty()){
-			if(step_cost_m && args::progress){
-				cur_steps += step_cost_m->cost[rule.jumpTarget];
+		//dead rules are detected without materializing the intersection
+		const set_t& matching_set = matchingSet<set_t>(run,rule);
+		if(!matching_set.intersects(try_match)){
+			if(step_cost_m && run.progress){
+				run.cur_steps += step_cost_m->cost[rule.jumpTarget];
 			}
-			rule.deadMatch++;
-			rule.deadJump++;
+			counters.deadMatch++;
+			counters.deadJump++;
 			continue;
-		}else{
-			rule.aliveMatch++;
-			if(consumer_run_m){
-				rule.matched += match.getAmountPoints();
-			}
+		}
+		auto match = matching_set;
+		match.INTERSECTION(try_match);
+		counters.aliveMatch++;
+		if(run.count_matched){
+			counters.matched += amountPoints(run,match);
 		}
 		assert(rule.jumpTarget != nullptr);
 		if(rule.jumpTarget->special == Chain::Special::RETURN){
 			ret.not_matched.UNION(match);
 			continue;
 		}
-		try_match.INTERSECTION_NEGATED(rule.maximumMatchingSet);
-		if(rule.jumpTarget->special == Chain::Special::DNAT){
+		try_match.INTERSECTION_NEGATED(matching_set);
+		if(rule.jumpTarget->special == Chain::Special::DNAT || rule.jumpTarget->special == Chain::Special::SNAT){
 			assert(rule.nat.has_value());
-			const Rule::NAT_Transform& transform = *rule.nat;
-
-			for(auto& seg : match.segments){
-				seg.setInterval<PSegment::DST_IP_INDEX>(
-						transform.start_ip,
-						transform.end_ip);
-				if(transform.has_port_change){
-					seg.setInterval<PSegment::DST_PORT_INDEX>(
-						transform.start_port,
-						transform.end_port);
-				}
-			}
-
-			match.compact();
-			try_match.UNION(match);
-			ret.somethingAccepted = true;
-			continue;
-		}else if(rule.jumpTarget->special == Chain::Special::SNAT){
-			assert(rule.nat.has_value());
-			const Rule::NAT_Transform& transform = *rule.nat;
-			for(auto& seg : match.segments){
-				seg.setInterval<PSegment::SRC_IP_INDEX>(
-						transform.start_ip,
-						transform.end_ip);
-				if(transform.has_port_change){
-					seg.setInterval<PSegment::SRC_PORT_INDEX>(
-						transform.start_port,
-						transform.end_port);
-				}else{
-					auto& p_start = seg.getStart<PSegment::SRC_PORT_INDEX>();
-					auto& p_end = seg.getEnd<PSegment::SRC_PORT_INDEX>();
-					if(p_start <= 511)p_start = 0;
-					else if(p_start <= 1023)p_start = 512;
-					else p_start = 1024;
-					if(p_end >= 1024)p_end = std::numeric_limits<std::remove_reference_t<decltype(p_end)>>::max();
-					else if(p_end >= 512)p_end = 1023;
-					else p_end = 511;
-				}
+			if constexpr(std::is_same_v<set_t,CSET>){
+				translate(match,rule,*run.compression);
+			}else{
+				translate(match,rule);
 			}
-			match.compact();
 			try_match.UNION(match);
 			ret.somethingAccepted = true;
 			continue;
 		}
 
-		auto [somethingAccepted,remaining] = pipeChain(*rule.jumpTarget,match);
+		auto [somethingAccepted,remaining] = pipeChain(run,*rule.jumpTarget,match);
 		if(!somethingAccepted)remaining = std::move(match);
 		if(somethingAccepted){
-			rule.aliveJump++;
+			counters.aliveJump++;
 		}else{
-			rule.deadJump++;
+			counters.deadJump++;
 		}
 		if(rule.jumpType == JumpType::GOTO){
 			ret.not_matched.UNION(remaining);
@@ -183,7 +560,7 @@ IpAnalyzer::PipeResult IpAnalyzer::pipeChain(Chain& chain, PSET try_match){
 	ret.not_matched.UNION(try_match);
 	switch(chain.policy){
 		case Chain::Policy::ACCEPT:
-			accepted.UNION(ret.not_matched);
+			run.accepted.UNION(ret.not_matched);
 			[[fallthrough]];
 		case Chain::Policy::DROP:
 			[[fallthrough]];
@@ -192,28 +569,45 @@ IpAnalyzer::PipeResult IpAnalyzer::pipeChain(Chain& chain, PSET try_match){
 	}
 	return ret;
 }
-void IpAnalyzer::pipeIfAvailable(std::string_view table_name, std::string_view chain_name){
+template<typename set_t>
+void IpAnalyzer::pipeIfAvailable(pipe_run_t<set_t>& run, std::string_view table_name, std::string_view chain_name){
+	if(!run.complete)return;
 	auto chain = findChain(table_name, chain_name);
 	if(chain == nullptr)return;
-	auto try_match = std::move(accepted);
-	accepted = PSET();
+	auto try_match = std::move(run.accepted);
+	run.accepted = set_t();
+	auto pipe = [&](){
+		try{
+			pipeChain(run,*chain,std::move(try_match));
+		}catch(const std::bad_alloc&){
+			//rules that matched are still alive, but no rule can be proven dead anymore
+			run.complete = false;
+			run.accepted = set_t();
+			mlog::error("ran out of memory while piping {}|{}, try a lower --memory-limit or more space in $TMPDIR\n",table_name,chain_name);
+		}
+	};
+	if(!run.progress){
+		//the prefixes of mlog are shared by all threads
+		pipe();
+		return;
+	}
 
 	/* mlog::pushPrefix(fmt::format("[{}|{}]",table_name,chain_name)); */
 	auto prefix = fmt::format("[{}|{}]",table_name,chain_name);
 	mlog::pushPrefix([&](){return prefix;});
 
 	if(step_cost_m){
-		total_steps = step_cost_m->cost[chain];
-		cur_steps = 0;
+		run.total_steps = step_cost_m->cost[chain];
+		run.cur_steps = 0;
 		mlog::pushPrefix([&](){
-					return fmt::format("[{:6.2f}%]", 100*(cur_steps/(double)(total_steps+1)));
+					return fmt::format("[{:6.2f}%]", 100*(run.cur_steps/(double)(run.total_steps+1)));
 				});
 	}else{
-		total_steps = -1;
+		run.total_steps = -1;
 	}
 
 
-	pipeChain(*chain,try_match);
+	pipe();
 
 
 	mlog::popPrefix();
@@ -262,53 +656,208 @@ size_t IpAnalyzer::getTotalStepCost(){
 	ret += stepCostIfAvailable(NAT_TABLE,POSTROUTING_CHAIN);
 	return ret;
 }
-void IpAnalyzer::pipeAll(PSET try_match){
-	accepted = try_match;
+template<typename set_t>
+void IpAnalyzer::pipeAll(pipe_run_t<set_t>& run, set_t try_match){
+	run.accepted = try_match;
+
+	pipeIfAvailable(run,RAW_TABLE,PREROUNTING_CHAIN);
+	pipeIfAvailable(run,MANGLE_TABLE,PREROUNTING_CHAIN);
+	pipeIfAvailable(run,NAT_TABLE,PREROUNTING_CHAIN);
+
+	set_t store_accepted = run.accepted;
 
-	pipeIfAvailable(RAW_TABLE,PREROUNTING_CHAIN);
-	pipeIfAvailable(MANGLE_TABLE,PREROUNTING_CHAIN);
-	pipeIfAvailable(NAT_TABLE,PREROUNTING_CHAIN);
+	pipeIfAvailable(run,MANGLE_TABLE,INPUT_CHAIN);
+	pipeIfAvailable(run,NAT_TABLE,INPUT_CHAIN);
+	pipeIfAvailable(run,FILTER_TABLE,INPUT_CHAIN);
 
-	PSET store_accepted = accepted;
+	run.accepted = std::move(store_accepted);
 
-	pipeIfAvailable(MANGLE_TABLE,INPUT_CHAIN);
-	pipeIfAvailable(NAT_TABLE,INPUT_CHAIN);
-	pipeIfAvailable(FILTER_TABLE,INPUT_CHAIN);
+	pipeIfAvailable(run,MANGLE_TABLE,FORWARD_CHAIN);
+	pipeIfAvailable(run,FILTER_TABLE,FORWARD_CHAIN);
 
-	accepted = std::move(store_accepted);
+	pipeIfAvailable(run,MANGLE_TABLE,POSTROUTING_CHAIN);
+	pipeIfAvailable(run,NAT_TABLE,POSTROUTING_CHAIN);
 
-	pipeIfAvailable(MANGLE_TABLE,FORWARD_CHAIN);
-	pipeIfAvailable(FILTER_TABLE,FORWARD_CHAIN);
+	run.accepted = std::move(try_match);
 
-	pipeIfAvailable(MANGLE_TABLE,POSTROUTING_CHAIN);
-	pipeIfAvailable(NAT_TABLE,POSTROUTING_CHAIN);
+	pipeIfAvailable(run,RAW_TABLE,OUTPUT_CHAIN);
+	pipeIfAvailable(run,MANGLE_TABLE,OUTPUT_CHAIN);
+	pipeIfAvailable(run,NAT_TABLE,OUTPUT_CHAIN);
+	pipeIfAvailable(run,FILTER_TABLE,OUTPUT_CHAIN);
 
-	accepted = std::move(try_match);
+	pipeIfAvailable(run,MANGLE_TABLE,POSTROUTING_CHAIN);
+	pipeIfAvailable(run,NAT_TABLE,POSTROUTING_CHAIN);
+}
+template auto IpAnalyzer::makeRun<PSET>() const -> pipe_run_t<PSET>;
+template void IpAnalyzer::pipeAll<PSET>(pipe_run_t<PSET>&, PSET);
+template auto IpAnalyzer::makeRun<CSET>() const -> pipe_run_t<CSET>;
+template void IpAnalyzer::pipeAll<CSET>(pipe_run_t<CSET>&, CSET);
+template auto IpAnalyzer::makeRun<PacketBDD>() const -> pipe_run_t<PacketBDD>;
+template void IpAnalyzer::pipeAll<PacketBDD>(pipe_run_t<PacketBDD>&, PacketBDD);
+template auto IpAnalyzer::makeRun<PacketClasses>() const -> pipe_run_t<PacketClasses>;
+template void IpAnalyzer::pipeAll<PacketClasses>(pipe_run_t<PacketClasses>&, PacketClasses);
 
-	pipeIfAvailable(RAW_TABLE,OUTPUT_CHAIN);
-	pipeIfAvailable(MANGLE_TABLE,OUTPUT_CHAIN);
-	pipeIfAvailable(NAT_TABLE,OUTPUT_CHAIN);
-	pipeIfAvailable(FILTER_TABLE,OUTPUT_CHAIN);
+auto IpAnalyzer::packetClasses() -> const PacketPartition* {
+	if(partition_m || partition_failed_m)return partition_m.get();
+	auto begin = std::chrono::steady_clock::now();
+	//ignored rules are never piped or compared, so they don't split the packets
+	static const PSET nothing;
+	std::vector<const PSET*> predicates(rule_count_m);
+	std::vector<PacketPartition::translation_t> translations;
+	ruleset_m.forEachRule([&](Rule& rule){
+				predicates[rule.id] = rule.shouldBeIgnored ? &nothing : &rule.maximumMatchingSet;
+				if(rule.shouldBeIgnored || rule.jumpTarget == nullptr)return;
+				if(rule.jumpTarget->special == Chain::Special::DNAT || rule.jumpTarget->special == Chain::Special::SNAT){
+					translations.push_back({rule.id,[&rule](PacketBDD& set){translate(set,rule);}});
+				}
+			});
+	try{
+		partition_m = std::make_unique<PacketPartition>(predicates,std::move(translations));
+	}catch(const std::length_error&){
+		partition_failed_m = true;
+		mlog::warn("the rules split the packets into more than {} classes, using the bdd engine instead\n",PacketPartition::default_max_classes);
+		return nullptr;
+	}
+	mlog::info("packet classes: {} rules split the packets into {} classes in {}ms\n",rule_count_m,partition_m->size(),
+			std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now()-begin).count());
+	return partition_m.get();
+}
 
-	pipeIfAvailable(MANGLE_TABLE,POSTROUTING_CHAIN);
-	pipeIfAvailable(NAT_TABLE,POSTROUTING_CHAIN);
+auto IpAnalyzer::compression() -> const CoordinateCompression* {
+	if(compression_m || compression_failed_m)return compression_m.get();
+	auto begin = std::chrono::steady_clock::now();
+	static const PSET nothing;
+	std::vector<const PSET*> sets(rule_count_m,&nothing);
+	//the targets of NAT rules have to be ranges of ranks as well
+	std::vector<PSegment> targets;
+	ruleset_m.forEachRule([&](Rule& rule){
+				if(rule.shouldBeIgnored)return;
+				sets[rule.id] = &rule.maximumMatchingSet;
+				if(!rule.nat)return;
+				const auto& transform = *rule.nat;
+				bool dnat = rule.jumpTarget->special == Chain::Special::DNAT;
+				auto& target = targets.emplace_back();
+				if(dnat){
+					target.setInterval<PSegment::DST_IP_INDEX>(transform.start_ip,transform.end_ip);
+					if(transform.has_port_change){
+						target.setInterval<PSegment::DST_PORT_INDEX>(transform.start_port,transform.end_port);
+					}
+				}else{
+					target.setInterval<PSegment::SRC_IP_INDEX>(transform.start_ip,transform.end_ip);
+					if(transform.has_port_change){
+						target.setInterval<PSegment::SRC_PORT_INDEX>(transform.start_port,transform.end_port);
+					}
+				}
+				if(!dnat && !transform.has_port_change){
+					for(auto [start,end] : {std::pair{0,511},std::pair{512,1023},std::pair{1024,65535}}){
+						targets.emplace_back().setInterval<PSegment::SRC_PORT_INDEX>(start,end);
+					}
+				}
+			});
+	try{
+		compression_m = std::make_unique<CoordinateCompression>(sets,targets);
+	}catch(const std::length_error&){
+		compression_failed_m = true;
+		mlog::warn("the rules have too many interval boundaries to compress them, using the segments engine instead\n");
+		return nullptr;
+	}
+	compressed_sets_m.reserve(rule_count_m);
+	for(const auto* set : sets){
+		auto& compressed = compressed_sets_m.emplace_back(compression_m->compress(*set));
+		compressed.canonicalize();
+		compressed.segments.shrink_to_fit();
+		if(compressed.segments.size() >= CSET::index_threshold){
+			compressed.buildIndex();
+		}
+	}
+	mlog::info("coordinate compression: {} source and {} destination ip ranks in {}ms\n",
+			compression_m->ranks<PSegment::SRC_IP_INDEX>(),compression_m->ranks<PSegment::DST_IP_INDEX>(),
+			std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now()-begin).count());
+	return compression_m.get();
+}
+
+auto IpAnalyzer::pipeAll(const PSET& try_match, const run_options_t& options) -> run_result_t {
+	auto begin = std::chrono::steady_clock::now();
+	auto elapsed = [&begin](){
+		return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now()-begin).count();
+	};
+	if(args::engine == args::Engine::CLASSES && packetClasses() != nullptr){
+		auto run = makeRun<PacketClasses>();
+		run.count_matched = options.count_matched;
+		run.progress = options.progress;
+		pipeAll(run,partition_m->classesOf(try_match));
+		if(options.statistics){
+			mlog::info("classes engine: piped in {}ms\n",elapsed());
+		}
+		return {std::move(run.counters),run.complete};
+	}
+	if(args::engine == args::Engine::COMPRESSED && compression() != nullptr){
+		auto run = makeRun<CSET>();
+		run.count_matched = options.count_matched;
+		run.progress = options.progress;
+		pipeAll(run,compression_m->compress(try_match));
+		if(options.statistics){
+			mlog::info("compressed engine: piped in {}ms, {} bytes per segment instead of {}\n",elapsed(),sizeof(CSegment),sizeof(PSegment));
+		}
+		return {std::move(run.counters),run.complete};
+	}
+	if(args::engine == args::Engine::BDD || args::engine == args::Engine::CLASSES){
+		//the nodes of all sets of the run are freed with the manager
+		bdd::manager manager;
+		bdd::manager_scope scope(manager);
+		auto run = makeRun<PacketBDD>();
+		run.count_matched = options.count_matched;
+		run.progress = options.progress;
+		pipeAll(run,PacketBDD(try_match));
+		if(options.statistics){
+			mlog::info("bdd engine: piped in {}ms, {} nodes using {:.2f}MB\n",
+					elapsed(),manager.nodes(),manager.memory()/(1024.0*1024.0));
+		}
+		return {std::move(run.counters),run.complete};
+	}
+	auto run = makeRun<PSET>();
+	run.count_matched = options.count_matched;
+	run.progress = options.progress;
+	pipeAll(run,try_match);
+	if(options.statistics){
+		mlog::info("segments engine: piped in {}ms\n",elapsed());
+		mlog::info("pipe cache: {} hits, {} misses, {} entries using {:.2f}MB\n",
+				run.cache.hits,run.cache.misses,run.cache.entries.size(),run.cache.memory/(1024.0*1024.0));
+		if(run.cache.segments != 0){
+			mlog::debug("pipe cache: {:.1f} bytes per packed segment instead of {}\n",
+					run.cache.segment_bytes/(double)run.cache.segments,sizeof(PSegment));
+		}
+	}
+	return {std::move(run.counters),run.complete};
 }
 void IpAnalyzer::analyzeDeadRules(){
 	mlog::info("BEGINN DEAD RULE ANALYSIS\n");
 	mlog::info("ruleset complexity = {}\n",getTotalStepCost());
-	pipeAll(PSET{{{}}});
+	auto run = pipeAll(PSET{{{}}},{.progress = args::progress, .statistics = true});
+	if(spill::peakMappedBytes() != 0){
+		mlog::info("up to {:.2f}MB of packet sets were stored in temporary files\n",spill::peakMappedBytes()/(1024.0*1024.0));
+	}
+	auto allocations = bor::allocationStats();
+	mlog::debug("allocations: {} from the heap, {} from arenas in {} chunks\n",
+			allocations.heap_allocations,allocations.arena_allocations,allocations.arena_chunks);
+	mlog::debug("copies of vectors: {} shared, {} copied right away, {} copied when modified\n",
+			allocations.shared_copies,allocations.element_copies,allocations.detached_copies);
 
 	for(auto& table : ruleset_m.tables){
 		for(auto& chain : table.chains){
 			for(auto& rule : chain->rules){
-				if(!rule.touched)continue;
-				if(rule.aliveMatch == 0){
-					deadrule_analysis_results.deadRules.push_back(&rule);
-				} else if(rule.aliveJump == 0 
+				rule.counters = run.counters[rule.id];
+				if(rule.shouldBeIgnored || (!rule.counters.touched && run.complete))continue;
+				bool dead = rule.counters.aliveMatch == 0;
+				bool dead_jump = !dead && rule.counters.aliveJump == 0 
 						&& !rule.jumpTarget->isPredefined() 
 						&& !rule.jumpTarget->rules.empty()
-						&& !args::config.silence.no_jump_target.contains(rule.jumpTarget->name)
-				){
+						&& !args::config.silence.no_jump_target.contains(rule.jumpTarget->name);
+				if(!run.complete && (dead || dead_jump)){
+					undetermined_rules.push_back(&rule);
+				}else if(dead){
+					deadrule_analysis_results.deadRules.push_back(&rule);
+				}else if(dead_jump){
 					deadrule_analysis_results.deadJumps.push_back(&rule);
 				}
 			}
@@ -321,6 +870,9 @@ void IpAnalyzer::analyzeDeadRules(){
 		for(auto r : deadrule_analysis_results.deadJumps){
 			fmt::print("dead jump:\n{}: {}\n\n",r->line,r->line_str);
 		}
+		for(auto r : undetermined_rules){
+			fmt::print("undetermined:\n{}: {}\n\n",r->line,r->line_str);
+		}
 	}
 	mlog::success("DONE DEAD RULE ANALYSIS\n");
 }
@@ -493,29 +1045,55 @@ void IpAnalyzer::checkGraph(){
 }
 void IpAnalyzer::findDeadRuleConsumers(){
 	if(!deadrule_analysis_results.deadRules.empty()){
-		consumer_run_m.emplace();
 		mlog::info("BEGINN DEAD RULE CONSUMER IDENTIFICATION\n");
-		for(auto dead_rule : deadrule_analysis_results.deadRules){
-			mlog::log("===========================================================\n");
-			mlog::log("starting ({}): {}\n",dead_rule->line,dead_rule->line_str);
+		//the runs share the packet classes, which have to be computed before
+		if(args::engine == args::Engine::CLASSES)packetClasses();
+		if(args::engine == args::Engine::COMPRESSED)compression();
+		const auto& dead_rules = deadrule_analysis_results.deadRules;
+		//every dead rule is piped in its own run, consumers are ordered by the packets they took away
+		std::vector<std::vector<std::pair<Rule*,long double>>> consumers(dead_rules.size());
+		bool parallel = args::threads > 1;
+#pragma omp parallel for schedule(dynamic,1) num_threads(args::regionThreads())
+		for(size_t i = 0; i < dead_rules.size(); ++i){
+			auto dead_rule = dead_rules[i];
+			if(!parallel){
+				mlog::log("===========================================================\n");
+				mlog::log("starting ({}): {}\n",dead_rule->line,dead_rule->line_str);
+			}
 
-			ruleset_m.resetRules();
-			pipeAll(dead_rule->maximumMatchingSet);
+			auto run = pipeAll(dead_rule->maximumMatchingSet,{.count_matched = true, .progress = args::progress && !parallel});
+			if(!run.complete){
+				mlog::warn("consumers of ({}) are incomplete, the run ran out of memory\n",dead_rule->line);
+			}
 
-			std::vector<Rule*> consumers;
 			ruleset_m.forEachRule([&](auto& rule){
-						if(rule.aliveMatch != 0 && (rule.jumpTarget->isDropping()
+						const auto& counters = run.counters[rule.id];
+						if(counters.aliveMatch != 0 && (rule.jumpTarget->isDropping()
 									|| (rule.table_name == dead_rule->table_name && rule.jumpTarget->special != Chain::Special::NONE))){
-							consumers.push_back(&rule);
+							consumers[i].emplace_back(&rule,counters.matched);
 						}
 					});
-			std::ranges::sort(consumers,[](const auto& r1, const auto& r2){
-						return r1->matched > r2->matched;
+			std::ranges::stable_sort(consumers[i],[](const auto& r1, const auto& r2){
+						return r1.second > r2.second;
 					});
-			for(auto rule : consumers){
-				mlog::log("consumed by ({}) {}: {}\n",rule->line,rule->matched,rule->line_str);
+			if(!parallel){
+				for(auto [rule,matched] : consumers[i]){
+					mlog::log("consumed by ({}) {}: {}\n",rule->line,matched,rule->line_str);
+				}
+			}
+		}
+		for(size_t i = 0; i < dead_rules.size(); ++i){
+			if(parallel){
+				mlog::log("===========================================================\n");
+				mlog::log("dead rule ({}): {}\n",dead_rules[i]->line,dead_rules[i]->line_str);
+				for(auto [rule,matched] : consumers[i]){
+					mlog::log("consumed by ({}) {}: {}\n",rule->line,matched,rule->line_str);
+				}
+			}
+			auto& result = deadrule_consumer_analysis_results.consumers[dead_rules[i]];
+			for(auto [rule,matched] : consumers[i]){
+				result.push_back(rule);
 			}
-			deadrule_consumer_analysis_results.consumers[dead_rule] = std::move(consumers);
 		}
 		mlog::success("DONE DEAD RULE CONSUMER IDENTIFICATION\n");
 	}else{
@@ -553,6 +1131,8 @@ void IpAnalyzer::printSummary(const parse_result_t& parse_results){
 	table.add_row({"ANALYSIS","AMOUNT","LINE NUMBERS"});
 	table.add_row({"dead rules", fmt::format("{}",deadrules.size()),join(deadrules)});
 	table.add_row({"dead jumps", fmt::format("{}",deadjumps.size()),join(deadjumps)});
+	if(!undetermined_rules.empty())
+		table.add_row({"undetermined rules",fmt::format("{}",undetermined_rules.size()),join(undetermined_rules)});
 	if(!empty_chains.empty())
 		table.add_row({"empty chains",fmt::format("{}",empty_chains.size()),join(empty_chains)});
 	if(!dead_chains.empty())
@@ -1,7 +1,36 @@
 #pragma once
 #include <vector>
+#include <chrono>
+#include <optional>
+#include <unordered_set>
 #include "Ruleset.hpp"
 #include "RulesetParser.hpp"
+#include "config.hpp"
+#include "PacketBDD.hpp"
+#include "PacketClasses.hpp"
+#include "CoordinateCompression.hpp"
+
+/**
+ * @brief decides when a set of packets growing during pipeChain is compacted
+ * @details INTERSECTION_NEGATED and UNION fragment the set of packets with every rule\n
+ * the set is compacted once its amount of segments grew by config_t::compaction_t::growth_ratio\n
+ * compared to the smallest size seen since the last compaction
+ */
+class CompactionPolicy {
+public:
+	CompactionPolicy(const config_t::compaction_t& config, size_t initial_size);
+	/**
+	 * compacts set if it fragmented too much since the last compaction
+	 * @returns the time spent compacting or std::nullopt if set was not compacted
+	 */
+	template<typename segment_t>
+	auto update(SegmentSet<segment_t>& set) -> std::optional<std::chrono::milliseconds>;
+	template<typename segment_t = PSegment>
+	static auto budget(const config_t::compaction_t& config) -> typename SegmentSet<segment_t>::compact_budget;
+private:
+	const config_t::compaction_t& config;
+	size_t reference_size;
+};
 
 /**
  * @brief Ruleset analysis algorithms => results => pretty printing
@@ -28,12 +57,14 @@ public:
 	 * compared to what the other rule matches
 	 * and is thus deemed unnecessary
 	 * the analysis currently only compares rules from the same chain
+	 * chains are analyzed in parallel by args::threads threads
 	 * */
 	void findSubsetRules();
 	/**
 	 * mergable rules are pairs of rules
 	 * where both rules could be rewritten as a single one
 	 * the analysis currently only compares rules from the same chain
+	 * chains are analyzed in parallel by args::threads threads
 	 * */
 	void findMergeableRules();
 	/**
@@ -42,6 +73,7 @@ public:
 	 * matched the packets and accepted or dropped them
 	 * as a result these consumer rules will be listed with the
 	 * number of packets that they took away from the dead rule
+	 * dead rules are piped in parallel by args::threads threads
 	 * */
 	void findDeadRuleConsumers();
 	/**
@@ -51,43 +83,143 @@ public:
 	 */
 	void checkGraph();
 	void printSummary(const parse_result_t&);
+	//!the analyzed ruleset with rule ids, maximumMatchingSets are canonical up to config_t::canonicalize_t::max_segments
+	auto ruleset() const -> const Ruleset& { return ruleset_m; }
 
 private:
 	//! \returns chain in table [table_name] with name [chain_name] in ruleset or nullptr, if unsuccessful
 	Chain* findChain(std::string_view table_name, std::string_view chain_name) ;
 
+	template<typename set_t>
 	struct PipeResult {
 		bool somethingAccepted = false;
-		PSET not_matched;
+		set_t not_matched;
+	};
+
+	/**
+	 * memoized results of pipeChain_uncached during a single run\n
+	 * entries are keyed on their sorted input, so the same segments piped through a chain share an entry\n
+	 * once a chain has been piped before, inputs that miss are canonicalized to find equal packets in other segments\n
+	 * once the memory limit is reached entries are still looked up, but no new ones are added
+	 * @sa config_t::pipe_cache_t
+	 */
+	struct pipe_cache_t {
+		//!entries are kept until the end of the run, their sets are stored in the DELTA encoding
+		struct entry_t {
+			const Chain* chain;
+			PackedSegments<PSegment> input;///<sorted or canonical packets piped through chain
+			bool something_accepted;///<PipeResult::somethingAccepted
+			PackedSegments<PSegment> not_matched;///<PipeResult::not_matched
+			PackedSegments<PSegment> accepted;///<packets added to pipe_run_t::accepted
+			std::vector<std::pair<size_t,Rule::counters_t>> counters;///<changes of the rule counters by Rule::id
+		};
+		std::unordered_multimap<size_t,entry_t> entries;///<keyed by hash of chain and input
+		std::unordered_map<const Chain*,std::vector<size_t>> reachable;///<ids of the rules a chain can evaluate
+		std::unordered_set<const Chain*> piped;///<chains piped at least once, only their inputs are canonicalized
+		size_t memory = 0;///<bytes used by the entries
+		size_t segments = 0;///<segments stored in the entries
+		size_t segment_bytes = 0;///<bytes used by the packed segments of the entries
+		size_t hits = 0;
+		size_t misses = 0;
 	};
+	/**
+	 * state of a single pipeAll call\n
+	 * runs with their own pipe_run_t don't share mutable state\n
+	 * and can be executed concurrently, as long as at most one of them reports progress\n
+	 * set_t is the representation of the packets, PSET, CSET, PacketBDD or PacketClasses
+	 */
+	template<typename set_t>
+	struct pipe_run_t {
+		std::vector<Rule::counters_t> counters;///<counters of every rule indexed by Rule::id
+		set_t accepted;///<packets that have been accepted during a pipeChain operation will be added to this set
+		bool count_matched = false;///<sum up the amount of packets matched by each rule
+		bool progress = false;///<log progress information
+		bool complete = true;///<false once the run ran out of memory, later chains aren't piped anymore
+
+		///!counter for progress information
+		///!every rule evaluation is one step
+		int total_steps = -1;
+		int cur_steps = -1;
+
+		pipe_cache_t cache;///<only used by runs on PSET
+		std::vector<set_t> matching_sets;///<Rule::maximumMatchingSet indexed by Rule::id, only filled for runs on other set types
+		const CoordinateCompression* compression = nullptr;///<translates the ranks of runs on CSET
+	};
+	/**
+	 * \returns a run with zeroed counters for all rules\n
+	 * PacketBDDs are created in the current bdd::manager, CSETs and PacketClasses\n
+	 * are taken from compression() and packetClasses(), which have to be computed before
+	 */
+	template<typename set_t = PSET>
+	pipe_run_t<set_t> makeRun() const;
 
 	/**
 	 * sends all packages represented by try_match through the contained rules 
 	 * and chains (recursion)
-	 * it is denoted in the Rule strcut wheter a rule has matched or jumped
+	 * it is denoted in the counters of the run wheter a rule has matched or jumped
 	 * sucessfully to identify wheter it is dead or not
+	 * results are looked up in and added to the cache of the run
+	 */
+	PipeResult<PSET> pipeChain(pipe_run_t<PSET>& run, Chain& chain, PSET try_match);
+	/**
+	 * other set types are not cached, their operations are cheap compared to canonicalizing a PSET\n
+	 * equal PacketBDDs share their nodes and the operations of the bdd::manager are memoized
 	 */
-	PipeResult pipeChain(Chain& chain, PSET try_match);
-	void pipeIfAvailable(std::string_view table_name, std::string_view chain_name);
+	template<typename set_t>
+	PipeResult<set_t> pipeChain(pipe_run_t<set_t>& run, Chain& chain, set_t try_match);
+	template<typename set_t>
+	PipeResult<set_t> pipeChain_uncached(pipe_run_t<set_t>& run, Chain& chain, set_t try_match);
+	//! \returns ids of all rules in chain and the chains it jumps to
+	auto reachableRules(pipe_cache_t& cache, const Chain& chain) -> const std::vector<size_t>&;
+	template<typename set_t>
+	void pipeIfAvailable(pipe_run_t<set_t>& run, std::string_view table_name, std::string_view chain_name);
 	/**
 	 * models the sequence of chains that is used in iptables
 	 * by consequtive pipeChain calls
 	 */
-	void pipeAll(PSET try_match);
+	template<typename set_t>
+	void pipeAll(pipe_run_t<set_t>& run, set_t try_match);
+
+	struct run_options_t {
+		bool count_matched = false;///<pipe_run_t::count_matched
+		bool progress = false;///<pipe_run_t::progress
+		bool statistics = false;///<log the runtime and memory of the run
+	};
+	struct run_result_t {
+		std::vector<Rule::counters_t> counters;///<pipe_run_t::counters
+		bool complete;///<pipe_run_t::complete
+	};
+	/**
+	 * pipes try_match through all chains in a new run\n
+	 * the packets are represented by PSET, CSET, PacketBDD or PacketClasses as selected by args::engine
+	 */
+	auto pipeAll(const PSET& try_match, const run_options_t& options) -> run_result_t;
+	/**
+	 * computes the packet classes of the maximumMatchingSets on the first call\n
+	 * the predicate of a class is the Rule::id of its rule
+	 * @returns nullptr if the rules split the packets into too many classes
+	 */
+	auto packetClasses() -> const PacketPartition*;
+	/**
+	 * computes the coordinate compression of the maximumMatchingSets and NAT targets on the first call
+	 * @returns nullptr if a dimension has too many interval boundaries
+	 */
+	auto compression() -> const CoordinateCompression*;
 	size_t getTotalStepCost();
 
 private:
 	Ruleset ruleset_m;
-	PSET accepted;///<packets that have been accepted during a pipeChain operation will be added to this set
+	size_t rule_count_m = 0;///<amount of rules in ruleset_m
 
 	struct step_cost_t {
 		std::unordered_map<const Chain*,size_t> cost;
 	};
 	std::optional<step_cost_t> step_cost_m;///<yielded by checkGraph analysis
-	struct consumer_run_t {
-		Chain* dead_rule_chain;
-	};
-	std::optional<consumer_run_t> consumer_run_m;///<yielded by checkGraph analysis
+	std::unique_ptr<PacketPartition> partition_m;///<yielded by packetClasses
+	bool partition_failed_m = false;
+	std::unique_ptr<CoordinateCompression> compression_m;///<yielded by compression
+	std::vector<CSET> compressed_sets_m;///<compressed maximumMatchingSets indexed by Rule::id
+	bool compression_failed_m = false;
 
 	struct graph_analysis_results_t {
 		std::vector<const Chain*> emptyChains;
@@ -99,6 +231,8 @@ private:
 		std::vector<Rule*> deadRules;
 		std::vector<Rule*> deadJumps;
 	} deadrule_analysis_results;
+	//!rules that would be dead or dead jumps, but the dead rule analysis ran out of memory before proving it
+	std::vector<Rule*> undetermined_rules;
 
 	struct deadrule_consumer_analysis_results_t {
 		std::unordered_map<Rule*,std::vector<Rule*>> consumers;
@@ -110,9 +244,4 @@ private:
 	struct mergeable_rule_analysis_results_t {
 		std::vector<std::pair<Rule*,Rule*>> rules;
 	} mergeable_rule_results;
-
-	///!counter for progress information
-	///!every rule evaluation is one step
-	int total_steps = -1;
-	int cur_steps = -1;
 };
@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 #include <sstream>
+#include <map>
 #include "RulesetParser.hpp"
+#include "args.hpp"
 
 #define private public
 #include "IpAnalyzer.hpp"
@@ -77,6 +79,24 @@ TEST(ipanalyzer,match_set_with_list_set){
 	EXPECT_TRUE(contains(analyzer.deadrule_analysis_results.deadRules,dead_rule_lineno,lineCompare));
 	EXPECT_EQ(analyzer.deadrule_analysis_results.deadRules.size(),1);
 }
+TEST(ipanalyzer,match_set_intersects_ip_restriction){
+	auto analyzer = setupAnalyzer(
+		"create abc hash:net\n"
+		"add abc 1.2.3.0/25\n"
+		"add abc 1.2.3.128/25\n"
+		"add abc 10.0.0.0/8\n",
+
+		"*raw\n"
+		"-A PREROUTING -s 10.0.0.0/8 --match-set abc src -j ACCEPT\n"
+		"-A PREROUTING -s 1.2.3.0/24 -j ACCEPT\n"
+		"-A PREROUTING -s 10.1.0.0/16 -j ACCEPT\n"
+	);
+	analyzer.analyzeDeadRules();
+
+	auto dead_rule_lineno = {4};
+	EXPECT_TRUE(contains(analyzer.deadrule_analysis_results.deadRules,dead_rule_lineno,lineCompare));
+	EXPECT_EQ(analyzer.deadrule_analysis_results.deadRules.size(),1);
+}
 
 TEST(ipanalyzer,match_set2){
 	auto analyzer = setupAnalyzer(
@@ -163,6 +183,25 @@ TEST(ipanalyzer,subset_rule_port){
 	EXPECT_TRUE(contains(subset_rules,subset_rules_expected,linePairCompare));
 	EXPECT_EQ(subset_rules.size(),2);
 }
+TEST(ipanalyzer,subset_rule_empty){
+	auto analyzer = setupAnalyzer(
+		"*raw\n"
+		":PREROUTING DROP [0:0]\n"
+		"-A PREROUTING ! -s 0.0.0.0/0 -j ACCEPT\n"
+		"-A PREROUTING -s 1.2.3.0/24 -j DROP\n"
+		"-A PREROUTING -s 1.2.3.4/32 -j ACCEPT\n"
+		"COMMIT\n"
+	);
+	analyzer.findSubsetRules();
+
+	//the empty rule skips the rule with another target, as it intersects none
+	auto subset_rules_expected = {
+		std::pair{3,5}
+	};
+	auto& subset_rules = analyzer.subset_rule_results.rules;
+	EXPECT_TRUE(contains(subset_rules,subset_rules_expected,linePairCompare));
+	EXPECT_EQ(subset_rules.size(),1);
+}
 TEST(ipanalyzer,snat){
 	auto analyzer = setupAnalyzer(
 		"*raw\n"
@@ -197,6 +236,35 @@ TEST(ipanalyzer, different_ports_mergeable){
 	EXPECT_TRUE(contains(mergable_rules,mergable_rules_expect,linePairCompare));
 	EXPECT_EQ(mergable_rules.size(),1);
 }
+TEST(ipanalyzer, parallel_analysis_is_deterministic){
+	//more rules than fit into a single block of rows
+	std::string ruleset = "*raw\n";
+	for(int i = 0; i < 200; ++i){
+		ruleset += fmt::format("-A PREROUTING -dport {} -j ACCEPT\n",i);
+	}
+	for(int i = 0; i < 200; ++i){
+		ruleset += "-A OUTPUT -dport 10 -j ACCEPT\n";
+	}
+	auto lines = [](const auto& pairs){
+		std::vector<std::pair<int,int>> ret;
+		for(auto [r1,r2] : pairs)ret.emplace_back(r1->line,r2->line);
+		return ret;
+	};
+	auto analyze = [&](int threads){
+		args::threads = threads;
+		auto analyzer = setupAnalyzer(ruleset.c_str());
+		analyzer.findMergeableRules();
+		analyzer.findSubsetRules();
+		return std::pair{lines(analyzer.mergeable_rule_results.rules),lines(analyzer.subset_rule_results.rules)};
+	};
+	auto [mergeable1,subset1] = analyze(1);
+	auto [mergeable4,subset4] = analyze(4);
+	args::threads = 1;
+	EXPECT_EQ(mergeable1.size(),199+199);
+	EXPECT_EQ(subset1.size(),199);
+	EXPECT_EQ(mergeable1,mergeable4);
+	EXPECT_EQ(subset1,subset4);
+}
 TEST(ipanalyzer, different_protocols_not_mergable){
 	auto analyzer = setupAnalyzer(
 		"*raw\n"
@@ -275,3 +343,160 @@ TEST(ipanalyzer, bug_consumers_in_output){
 		EXPECT_EQ(consumers.size(),1);
 	}
 }
+TEST(ipanalyzer, parallel_consumer_runs_are_independent){
+	const char* ruleset =
+		"*raw\n"
+		"-A OUTPUT -s 10.0.0.0/8 -j DROP\n"
+		"-A OUTPUT -s 10.0.0.1 -j ACCEPT\n"
+		"-A OUTPUT -s 192.168.0.0/16 -j DROP\n"
+		"-A OUTPUT -s 192.168.1.0/24 -j ACCEPT\n"
+		"-A OUTPUT -s 192.168.1.1 -j ACCEPT\n"
+		"-A OUTPUT -s 172.16.0.1 -j ACCEPT\n"
+		"-A OUTPUT -s 172.16.0.1 -j ACCEPT\n";
+	auto consumers = [&](int threads){
+		args::threads = threads;
+		auto analyzer = setupAnalyzer(ruleset);
+		analyzer.analyzeDeadRules();
+		analyzer.findDeadRuleConsumers();
+		std::map<int,std::vector<int>> ret;
+		for(const auto& [dead_rule,consumers] : analyzer.deadrule_consumer_analysis_results.consumers){
+			for(auto rule : consumers)ret[dead_rule->line].push_back(rule->line);
+		}
+		return ret;
+	};
+	auto sequential = consumers(1);
+	auto parallel = consumers(4);
+	args::threads = 1;
+	std::map<int,std::vector<int>> expected = {{3,{2}},{5,{4}},{6,{4}},{8,{7}}};
+	EXPECT_EQ(sequential,expected);
+	EXPECT_EQ(parallel,expected);
+}
+TEST(ipanalyzer, pipe_cache_keeps_counters){
+	//user_chain doesn't drop any of the packets piped into it, so the second jump pipes the same packets
+	const char* ruleset =
+		"*filter\n"
+		"-A FORWARD -s 1.0.0.0/8 -j user_chain\n"
+		"-A FORWARD -s 1.0.0.0/8 -j user_chain\n"
+		"-A FORWARD -s 1.2.3.4 -j ACCEPT\n"
+		"-A user_chain -s 5.5.5.5 -j DROP\n"
+		"-A user_chain -p udp -s 5.0.0.0/8 -j DROP\n"
+		"COMMIT\n"
+		"*nat\n"
+		"-A POSTROUTING -d 1.2.3.4 -j ACCEPT\n"
+		"-A POSTROUTING -d 1.2.3.0/24 -j ACCEPT\n"
+		"COMMIT\n";
+	auto counters = [&](bool enabled){
+		args::config.pipe_cache.enabled = enabled;
+		auto analyzer = setupAnalyzer(ruleset);
+		auto run = analyzer.makeRun();
+		run.count_matched = true;
+		analyzer.pipeAll(run,PSET{{{}}});
+		args::config.pipe_cache = {};
+		return std::pair{run.counters,run.cache.hits};
+	};
+	auto [cached,hits] = counters(true);
+	auto [uncached,no_hits] = counters(false);
+	EXPECT_GT(hits,0);
+	EXPECT_EQ(no_hits,0);
+	EXPECT_EQ(cached,uncached);
+}
+TEST(ipanalyzer, match_set_shared_after_construction){
+	for(size_t max_segments : {0,1024}){
+		args::config.canonicalize.max_segments = max_segments;
+		auto analyzer = setupAnalyzer(
+			"create abc hash:net,port\n"
+			"add abc 1.2.3.0/24,udp:53\n"
+			"add abc 1.2.3.128/25,udp:53\n"
+			"add abc 4.3.2.1,tcp:80\n",
+
+			"*filter\n"
+			"-A INPUT -m set --match-set abc src,dst -j ACCEPT\n"
+			"-A INPUT -m set --match-set abc src,dst -j DROP\n"
+			"COMMIT\n"
+		);
+		args::config.canonicalize = {};
+		const auto& rules = analyzer.ruleset_m.tables[0].findChain("INPUT")->rules;
+		ASSERT_EQ(2,rules.size());
+		const auto& set1 = rules[0].maximumMatchingSet;
+		const auto& set2 = rules[1].maximumMatchingSet;
+		EXPECT_TRUE(set1.segments.sharesStorage());
+		EXPECT_EQ(set1.segments.data(),set2.segments.data());
+		EXPECT_EQ(max_segments != 0,set2.isCanonical());
+	}
+}
+TEST(ipanalyzer, engines_find_the_same_rules){
+	const char* ruleset =
+		"*raw\n"
+		":PREROUTING DROP [0:0]\n"
+		"-A PREROUTING -s 0.0.0.0/24 -j ACCEPT\n"
+		"-A PREROUTING -d 0.0.1.0/24 -sports 20 -j ACCEPT\n"
+		"-A PREROUTING -d 0.0.1.2/32 -sports 20:210 -j ACCEPT\n"
+		"-A PREROUTING -d 1.0.0.0/12 -dports 1 -j other\n"
+		"-A other -d 2.2.2.2/32 -j DROP\n"
+		"COMMIT\n"
+		"*nat\n"
+		"-A PREROUTING -d 1.2.4.0/24 -j DNAT --to-destination 1.2.3.4\n"
+		"-A PREROUTING -d 1.2.4.0/24 -j ACCEPT\n"
+		"-A PREROUTING -d 1.2.3.4 -j ACCEPT\n"
+		"-A PREROUTING -s 1.2.4.0/24 -p tcp -j SNAT --to-source 1.2.3.0/24\n"
+		"-A PREROUTING -s 1.2.4.0/24 -p tcp -j ACCEPT\n"
+		"COMMIT\n"
+		"*filter\n"
+		"-A OUTPUT -s 1.2.3.4/32 -j ACCEPT\n"
+		"-A OUTPUT -s 1.2.3.0/24 -j ACCEPT\n"
+		"-A OUTPUT -dport 10 -j DROP\n"
+		"-A OUTPUT -dport 11 -j DROP\n"
+		"COMMIT\n";
+	using lines_t = std::vector<std::pair<int,int>>;
+	auto analyze = [&](args::Engine engine){
+		args::engine = engine;
+		auto analyzer = setupAnalyzer(ruleset);
+		analyzer.analyzeDeadRules();
+		analyzer.findSubsetRules();
+		analyzer.findMergeableRules();
+		args::engine = args::Engine::SEGMENTS;
+		std::tuple<std::vector<int>,std::vector<int>,lines_t,lines_t> ret;
+		auto& [dead_rules,dead_jumps,subset_rules,mergeable_rules] = ret;
+		for(auto rule : analyzer.deadrule_analysis_results.deadRules)dead_rules.push_back(rule->line);
+		for(auto rule : analyzer.deadrule_analysis_results.deadJumps)dead_jumps.push_back(rule->line);
+		for(auto [r1,r2] : analyzer.subset_rule_results.rules)subset_rules.emplace_back(r1->line,r2->line);
+		for(auto [r1,r2] : analyzer.mergeable_rule_results.rules)mergeable_rules.emplace_back(r1->line,r2->line);
+		return ret;
+	};
+	auto segments = analyze(args::Engine::SEGMENTS);
+	EXPECT_EQ(std::get<0>(segments),(std::vector<int>{7,11,14}));
+	EXPECT_EQ(std::get<1>(segments),(std::vector<int>{6}));
+	EXPECT_EQ(std::get<2>(segments),(lines_t{{17,18}}));
+	EXPECT_EQ(analyze(args::Engine::BDD),segments);
+	EXPECT_EQ(analyze(args::Engine::CLASSES),segments);
+	EXPECT_EQ(analyze(args::Engine::COMPRESSED),segments);
+}
+TEST(compaction_policy, compacts_after_growth){
+	config_t::compaction_t config;
+	config.growth_ratio = 2;
+	config.min_segments = 4;
+	PSET set;
+	for(uint32_t i = 0; i < 4; ++i){
+		set.segments.emplace_back(i*10,i*10+9);
+	}
+	CompactionPolicy policy(config,4);
+	EXPECT_FALSE(policy.update(set).has_value());
+	EXPECT_EQ(set.segments.size(),4);
+	for(uint32_t i = 4; i < 8; ++i){
+		set.segments.emplace_back(i*10,i*10+9);
+	}
+	EXPECT_TRUE(policy.update(set).has_value());
+	EXPECT_EQ(set.segments.size(),1);
+}
+TEST(compaction_policy, ignores_small_sets){
+	config_t::compaction_t config;
+	config.growth_ratio = 2;
+	config.min_segments = 100;
+	PSET set;
+	for(uint32_t i = 0; i < 8; ++i){
+		set.segments.emplace_back(i*10,i*10+9);
+	}
+	CompactionPolicy policy(config,1);
+	EXPECT_FALSE(policy.update(set).has_value());
+	EXPECT_EQ(set.segments.size(),8);
+}
@@ -0,0 +1,174 @@
+#pragma once
+#include "vector.hpp"
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <type_traits>
+
+/**
+ * @brief compact storage for a collection of segments that is rarely accessed
+ * @details Segment nests its dimensions through inheritance, which pads the\n
+ * fields to the alignment of the largest one (32 bytes for PSegment)\n
+ * two encodings are supported:
+ * - @b FIXED stores the start and end of every dimension byte by byte\n
+ *   without padding, every segment takes fixed_bytes
+ * - @b DELTA stores every value as the zigzag varint of its difference to\n
+ *   the same value of the previous segment, sets sorted by their first dimension\n
+ *   (e.g. canonical ones) and values repeated between neighbours take a byte\n
+ *   segments have to be unpacked in order
+ *
+ * in the following complexity descriptions:
+ * - @b n denotes the amount of packed segments
+ * - @b d denotes the dimensionality of the segment type
+ */
+template<typename segment_t>
+class PackedSegments {
+public:
+	enum class Encoding {
+		FIXED, DELTA
+	};
+	template<int dim>
+	using field_t = std::remove_cvref_t<decltype(std::declval<const segment_t&>().template getStart<dim>())>;
+
+	//!bytes of a segment in the FIXED encoding
+	constexpr static size_t fixed_bytes = []<size_t ... dims>(std::index_sequence<dims...>){
+				return (size_t{0} + ... + (2*sizeof(field_t<dims>)));
+			}(std::make_index_sequence<segment_t::dimensions>{});
+
+	PackedSegments() = default;
+	/**
+	 * runtime O(n*d)
+	 */
+	explicit PackedSegments(const bor::vector<segment_t>& segments, Encoding encoding = Encoding::FIXED)
+		: size_m(segments.size()), encoding_m(encoding)
+	{
+		if(encoding == Encoding::FIXED){
+			data_m.resize_no_init(fixed_bytes*size_m);
+			uint8_t* out = data_m.data();
+			for(const auto& seg : segments)out = writeFixed(seg,out);
+			return;
+		}
+		//a varint of a 64bit value takes at most 10 bytes
+		data_m.resize_no_init(segment_t::dimensions*2*10*size_m);
+		uint8_t* out = data_m.data();
+		const segment_t* prev = nullptr;
+		for(const auto& seg : segments){
+			out = writeDelta(seg,prev,out);
+			prev = &seg;
+		}
+		data_m.resize_no_init(out-data_m.data());
+		data_m.shrink_to_fit();
+	}
+
+	/**
+	 * runtime O(n*d)
+	 */
+	auto unpack() const -> bor::vector<segment_t> {
+		bor::vector<segment_t> ret;
+		ret.resize_no_init(size_m);
+		const uint8_t* in = data_m.data();
+		for(size_t i = 0; i < size_m; ++i){
+			if(encoding_m == Encoding::FIXED){
+				in = readFixed(ret[i],in);
+			}else{
+				in = readDelta(ret[i],i == 0 ? nullptr : &ret[i-1],in);
+			}
+		}
+		return ret;
+	}
+	auto size() const -> size_t {
+		return size_m;
+	}
+	auto empty() const -> bool {
+		return size_m == 0;
+	}
+	auto encoding() const -> Encoding {
+		return encoding_m;
+	}
+	//!@returns the bytes used by the encoded segments
+	auto bytes() const -> size_t {
+		return data_m.capacity();
+	}
+	//!@returns whether both contain the same segments in the same order and encoding
+	bool operator==(const PackedSegments& other) const {
+		return size_m == other.size_m && encoding_m == other.encoding_m
+			&& data_m.size() == other.data_m.size()
+			&& (data_m.empty() || std::memcmp(data_m.data(),other.data_m.data(),data_m.size()) == 0);
+	}
+private:
+	template<int dim = 0>
+	static uint8_t* writeFixed(const segment_t& seg, uint8_t* out){
+		if constexpr(dim == segment_t::dimensions){
+			return out;
+		}else{
+			field_t<dim> start = seg.template getStart<dim>(), end = seg.template getEnd<dim>();
+			std::memcpy(out,&start,sizeof(start));
+			std::memcpy(out+sizeof(start),&end,sizeof(end));
+			return writeFixed<dim+1>(seg,out+2*sizeof(start));
+		}
+	}
+	template<int dim = 0>
+	static const uint8_t* readFixed(segment_t& seg, const uint8_t* in){
+		if constexpr(dim == segment_t::dimensions){
+			return in;
+		}else{
+			field_t<dim> start, end;
+			std::memcpy(&start,in,sizeof(start));
+			std::memcpy(&end,in+sizeof(start),sizeof(end));
+			seg.template setInterval<dim>(start,end);
+			return readFixed<dim+1>(seg,in+2*sizeof(start));
+		}
+	}
+
+	static uint8_t* writeVarint(int64_t value, uint8_t* out){
+		uint64_t zigzag = (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+		while(zigzag >= 0x80){
+			*out++ = static_cast<uint8_t>(zigzag) | 0x80;
+			zigzag >>= 7;
+		}
+		*out++ = static_cast<uint8_t>(zigzag);
+		return out;
+	}
+	static const uint8_t* readVarint(int64_t& value, const uint8_t* in){
+		uint64_t zigzag = 0;
+		for(int shift = 0;; shift += 7){
+			uint8_t byte = *in++;
+			zigzag |= static_cast<uint64_t>(byte & 0x7f) << shift;
+			if(byte < 0x80)break;
+		}
+		value = static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(zigzag & 1);
+		return in;
+	}
+	template<int dim = 0>
+	static uint8_t* writeDelta(const segment_t& seg, const segment_t* prev, uint8_t* out){
+		if constexpr(dim == segment_t::dimensions){
+			return out;
+		}else{
+			int64_t prev_start = prev ? prev->template getStart<dim>() : 0;
+			int64_t prev_end = prev ? prev->template getEnd<dim>() : 0;
+			out = writeVarint(static_cast<int64_t>(seg.template getStart<dim>())-prev_start,out);
+			out = writeVarint(static_cast<int64_t>(seg.template getEnd<dim>())-prev_end,out);
+			return writeDelta<dim+1>(seg,prev,out);
+		}
+	}
+	template<int dim = 0>
+	static const uint8_t* readDelta(segment_t& seg, const segment_t* prev, const uint8_t* in){
+		if constexpr(dim == segment_t::dimensions){
+			return in;
+		}else{
+			int64_t start, end;
+			in = readVarint(start,in);
+			in = readVarint(end,in);
+			if(prev){
+				start += prev->template getStart<dim>();
+				end += prev->template getEnd<dim>();
+			}
+			seg.template setInterval<dim>(static_cast<field_t<dim>>(start),static_cast<field_t<dim>>(end));
+			return readDelta<dim+1>(seg,prev,in);
+		}
+	}
+
+	bor::vector<uint8_t> data_m;
+	size_t size_m = 0;
+	Encoding encoding_m = Encoding::FIXED;
+};
@@ -0,0 +1,47 @@
+#include <gtest/gtest.h>
+#include <rapidcheck/gtest.h>
+#include "PackedSegments.hpp"
+#include "SegmentSet.hpp"
+#include "SegmentSet-generator.hpp"
+
+using Encoding = PackedSegments<PSegment>::Encoding;
+
+TEST(PackedSegments,fixed_encoding_has_no_padding){
+	EXPECT_EQ(PackedSegments<PSegment>::fixed_bytes,2*(4+4+2+2+1+1+1));
+	EXPECT_LT(PackedSegments<PSegment>::fixed_bytes,sizeof(PSegment));
+}
+TEST(PackedSegments,empty){
+	bor::vector<PSegment> segments;
+	PackedSegments<PSegment> packed(segments,Encoding::DELTA);
+	EXPECT_TRUE(packed.empty());
+	EXPECT_EQ(packed.unpack().size(),0);
+}
+TEST(PackedSegments,delta_encoding_compresses_sorted_sets){
+	bor::vector<PSegment> segments;
+	for(uint32_t i = 0; i < 1000; ++i){
+		segments.push_back(PSegment(i*256,i*256+255));
+	}
+	PackedSegments<PSegment> packed(segments,Encoding::DELTA);
+	//start and end advance by 256, which takes two bytes, all other values repeat
+	EXPECT_LT(packed.bytes(),segments.size()*(2*2+12+1));
+	EXPECT_EQ(packed.unpack(),segments);
+}
+RC_GTEST_PROP(PackedSegments,unpack_returns_the_packed_segments,(const PSET& set)){
+	for(auto encoding : {Encoding::FIXED,Encoding::DELTA}){
+		auto packed = set.pack(encoding);
+		RC_ASSERT(packed.size() == set.segments.size());
+		RC_ASSERT(packed.unpack() == set.segments);
+	}
+}
+RC_GTEST_PROP(PackedSegments,equal_exactly_for_equal_segments,(const PSET& set1, const PSET& set2)){
+	auto packed1 = set1.pack(Encoding::DELTA);
+	auto packed2 = set2.pack(Encoding::DELTA);
+	RC_ASSERT((packed1 == packed2) == (set1.segments == set2.segments));
+	RC_ASSERT(packed1 == set1.pack(Encoding::DELTA));
+}
+RC_GTEST_PROP(PackedSegments,unpacked_canonical_set_stays_canonical,(PSET set)){
+	set.canonicalize();
+	auto unpacked = PSET::unpack(set.pack(Encoding::DELTA),true);
+	RC_ASSERT(unpacked.isCanonical());
+	RC_ASSERT(unpacked.hash() == set.hash());
+}
@@ -0,0 +1,230 @@
+#include "PacketBDD.hpp"
+#include "util.hpp"
+#include <cmath>
+#include <functional>
+#include <unordered_set>
+
+namespace {
+	using node_id = bdd::manager::node_id;
+	using Op = bdd::manager::Op;
+
+	template<int index>
+	constexpr uint32_t width = 8*sizeof(decltype(std::declval<const PSegment&>().getStart<index>()));
+	//!@returns the variable of the most significant bit of dimension index
+	template<int index>
+	constexpr uint32_t offset(){
+		if constexpr(index == 0){
+			return 0;
+		}else{
+			return offset<index-1>()+width<index-1>;
+		}
+	}
+	static_assert(offset<PSegment::dimensions>() == PacketBDD::bits);
+
+	/**
+	 * @returns the node of all values of the bits variables starting at var that lie in start to end\n
+	 * followed by next for the variables after them
+	 */
+	node_id range(bdd::manager& mgr, uint32_t var, uint32_t bits, uint64_t start, uint64_t end, node_id next){
+		if(start > end)return bdd::manager::FALSE;
+		uint64_t max = (uint64_t{1} << bits)-1;
+		if(start == 0 && end == max)return next;
+		//at most one child of every node is neither empty nor full
+		uint64_t half = uint64_t{1} << (bits-1);
+		node_id low = start < half
+			? range(mgr,var+1,bits-1,start,std::min(end,half-1),next)
+			: bdd::manager::FALSE;
+		node_id high = end >= half
+			? range(mgr,var+1,bits-1,std::max(start,half)-half,end-half,next)
+			: bdd::manager::FALSE;
+		return mgr.make(var,low,high);
+	}
+	//!@returns the node of all packets in seg
+	template<int index = PSegment::dimensions-1>
+	node_id segment(bdd::manager& mgr, const PSegment& seg, node_id next = bdd::manager::TRUE){
+		next = range(mgr,offset<index>(),width<index>,seg.getStart<index>(),seg.getEnd<index>(),next);
+		if constexpr(index == 0){
+			return next;
+		}else{
+			return segment<index-1>(mgr,seg,next);
+		}
+	}
+	//!@returns the UNION of the segments from begin to end, joined pairwise to keep the intermediate results small
+	node_id segments(bdd::manager& mgr, const PSegment* begin, const PSegment* end){
+		if(begin == end)return bdd::manager::FALSE;
+		if(end-begin == 1)return begin->empty() ? bdd::manager::FALSE : segment(mgr,*begin);
+		auto mid = begin+(end-begin)/2;
+		node_id low = segments(mgr,begin,mid);
+		return mgr.apply(Op::OR,low,segments(mgr,mid,end));
+	}
+	//!@returns node with the variables from begin to end existentially quantified
+	node_id exists(bdd::manager& mgr, node_id id, uint32_t begin, uint32_t end, std::unordered_map<node_id,node_id>& memo){
+		auto node = mgr.node(id);
+		if(node.var >= end)return id;
+		if(auto iter = memo.find(id); iter != std::end(memo))return iter->second;
+		node_id low = exists(mgr,node.low,begin,end,memo);
+		node_id high = exists(mgr,node.high,begin,end,memo);
+		node_id ret = node.var >= begin ? mgr.apply(Op::OR,low,high) : mgr.make(node.var,low,high);
+		memo.emplace(id,ret);
+		return ret;
+	}
+}
+
+namespace bdd {
+	manager::manager(size_t cache_entries) : cache_m(cache_entries) {
+		nodes_m.push_back({PacketBDD::bits,FALSE,FALSE});
+		nodes_m.push_back({PacketBDD::bits,TRUE,TRUE});
+	}
+	auto manager::node_hash::operator()(const node_t& node) const noexcept -> size_t {
+		size_t ret = node.var;
+		for(size_t value : {size_t{node.low},size_t{node.high}}){
+			ret ^= value + 0x9e3779b97f4a7c15ull + (ret << 6) + (ret >> 2);
+		}
+		return ret;
+	}
+	auto manager::make(uint32_t var, node_id low, node_id high) -> node_id {
+		if(low == high)return low;
+		node_t node{var,low,high};
+		if(auto iter = unique_m.find(node); iter != std::end(unique_m))return iter->second;
+		//if inserting into unique_m throws the node stays unreachable
+		auto id = static_cast<node_id>(nodes_m.size());
+		nodes_m.push_back(node);
+		unique_m.emplace(node,id);
+		return id;
+	}
+	auto manager::apply(Op op, node_id node1, node_id node2) -> node_id {
+		switch(op){
+			case Op::AND:
+				if(node1 == FALSE || node2 == FALSE)return FALSE;
+				if(node1 == TRUE || node1 == node2)return node2;
+				if(node2 == TRUE)return node1;
+				break;
+			case Op::OR:
+				if(node1 == TRUE || node2 == TRUE)return TRUE;
+				if(node1 == FALSE || node1 == node2)return node2;
+				if(node2 == FALSE)return node1;
+				break;
+			case Op::AND_NOT:
+				if(node1 == FALSE || node2 == TRUE || node1 == node2)return FALSE;
+				if(node2 == FALSE)return node1;
+				break;
+		}
+		if(op != Op::AND_NOT && node1 > node2)std::swap(node1,node2);
+		auto& entry = cache_m[node_hash{}({static_cast<uint32_t>(op),node1,node2}) % cache_m.size()];
+		if(entry.valid && entry.op == op && entry.node1 == node1 && entry.node2 == node2){
+			return entry.result;
+		}
+		//nodes_m may grow during the recursion
+		node_t n1 = nodes_m[node1], n2 = nodes_m[node2];
+		uint32_t var = std::min(n1.var,n2.var);
+		node_id low = apply(op,n1.var == var ? n1.low : node1,n2.var == var ? n2.low : node2);
+		node_id high = apply(op,n1.var == var ? n1.high : node1,n2.var == var ? n2.high : node2);
+		node_id result = make(var,low,high);
+		entry = {node1,node2,result,op,true};
+		return result;
+	}
+	auto manager::memory() const -> size_t {
+		//every entry of the unique table is a list node holding the key, the value and a pointer
+		return util::getMemoryUsage_raw(nodes_m)
+			+ unique_m.size()*(sizeof(node_t)+sizeof(node_id)+sizeof(void*))
+			+ unique_m.bucket_count()*sizeof(void*)
+			+ util::getMemoryUsage_raw(cache_m);
+	}
+
+	static thread_local manager* current_m = nullptr;
+	manager& manager::current(){
+		if(current_m == nullptr){
+			static thread_local manager fallback;
+			return fallback;
+		}
+		return *current_m;
+	}
+	manager_scope::manager_scope(manager& mgr) : prev_m(current_m){
+		current_m = &mgr;
+	}
+	manager_scope::~manager_scope(){
+		current_m = prev_m;
+	}
+}
+
+PacketBDD::PacketBDD(const PSET& set)
+	: root_m(segments(bdd::manager::current(),set.segments.data(),set.segments.data()+set.segments.size()))
+{}
+template<int index>
+auto PacketBDD::range(uint64_t start, uint64_t end) -> PacketBDD {
+	return PacketBDD(::range(bdd::manager::current(),offset<index>(),width<index>,start,end,bdd::manager::TRUE));
+}
+
+void PacketBDD::UNION(const PacketBDD& other){
+	root_m = bdd::manager::current().apply(Op::OR,root_m,other.root_m);
+}
+void PacketBDD::INTERSECTION(const PacketBDD& other){
+	root_m = bdd::manager::current().apply(Op::AND,root_m,other.root_m);
+}
+void PacketBDD::INTERSECTION_NEGATED(const PacketBDD& other){
+	root_m = bdd::manager::current().apply(Op::AND_NOT,root_m,other.root_m);
+}
+void PacketBDD::NEGATE(){
+	root_m = bdd::manager::current().apply(Op::AND_NOT,bdd::manager::TRUE,root_m);
+}
+template<int index>
+void PacketBDD::setInterval(uint64_t start, uint64_t end){
+	auto& mgr = bdd::manager::current();
+	std::unordered_map<node_id,node_id> memo;
+	root_m = exists(mgr,root_m,offset<index>(),offset<index>()+width<index>,memo);
+	INTERSECTION(range<index>(start,end));
+}
+
+auto PacketBDD::isEmpty() const noexcept -> bool {
+	return root_m == bdd::manager::FALSE;
+}
+auto PacketBDD::intersects(const PacketBDD& other) const -> bool {
+	return bdd::manager::current().apply(Op::AND,root_m,other.root_m) != bdd::manager::FALSE;
+}
+auto PacketBDD::isSubsetOf(const PacketBDD& other) const -> bool {
+	return bdd::manager::current().apply(Op::AND_NOT,root_m,other.root_m) == bdd::manager::FALSE;
+}
+auto PacketBDD::getAmountPoints() const -> long double {
+	const auto& mgr = bdd::manager::current();
+	//assignments of the variables from the variable of a node on
+	std::unordered_map<node_id,long double> memo{{bdd::manager::FALSE,0},{bdd::manager::TRUE,1}};
+	std::function<long double(node_id)> count = [&](node_id id) -> long double {
+		if(auto iter = memo.find(id); iter != std::end(memo))return iter->second;
+		auto node = mgr.node(id);
+		long double ret = 0;
+		for(node_id child : {node.low,node.high}){
+			ret += std::ldexp(count(child),static_cast<int>(mgr.node(child).var-node.var-1));
+		}
+		memo.emplace(id,ret);
+		return ret;
+	};
+	return std::ldexp(count(root_m),static_cast<int>(mgr.node(root_m).var));
+}
+auto PacketBDD::nodes() const -> size_t {
+	const auto& mgr = bdd::manager::current();
+	std::unordered_set<node_id> visited;
+	std::vector<node_id> stack{root_m};
+	while(!stack.empty()){
+		node_id id = stack.back();
+		stack.pop_back();
+		if(id == bdd::manager::FALSE || id == bdd::manager::TRUE || !visited.insert(id).second)continue;
+		stack.push_back(mgr.node(id).low);
+		stack.push_back(mgr.node(id).high);
+	}
+	return visited.size();
+}
+
+template auto PacketBDD::range<PSegment::SRC_IP_INDEX>(uint64_t,uint64_t) -> PacketBDD;
+template auto PacketBDD::range<PSegment::DST_IP_INDEX>(uint64_t,uint64_t) -> PacketBDD;
+template auto PacketBDD::range<PSegment::SRC_PORT_INDEX>(uint64_t,uint64_t) -> PacketBDD;
+template auto PacketBDD::range<PSegment::DST_PORT_INDEX>(uint64_t,uint64_t) -> PacketBDD;
+template auto PacketBDD::range<PSegment::IN_INTERFACE_INDEX>(uint64_t,uint64_t) -> PacketBDD;
+template auto PacketBDD::range<PSegment::OUT_INTERFACE_INDEX>(uint64_t,uint64_t) -> PacketBDD;
+template auto PacketBDD::range<PSegment::PROTOCOL_INDEX>(uint64_t,uint64_t) -> PacketBDD;
+template void PacketBDD::setInterval<PSegment::SRC_IP_INDEX>(uint64_t,uint64_t);
+template void PacketBDD::setInterval<PSegment::DST_IP_INDEX>(uint64_t,uint64_t);
+template void PacketBDD::setInterval<PSegment::SRC_PORT_INDEX>(uint64_t,uint64_t);
+template void PacketBDD::setInterval<PSegment::DST_PORT_INDEX>(uint64_t,uint64_t);
+template void PacketBDD::setInterval<PSegment::IN_INTERFACE_INDEX>(uint64_t,uint64_t);
+template void PacketBDD::setInterval<PSegment::OUT_INTERFACE_INDEX>(uint64_t,uint64_t);
+template void PacketBDD::setInterval<PSegment::PROTOCOL_INDEX>(uint64_t,uint64_t);
@@ -0,0 +1,146 @@
+#pragma once
+#include "SegmentSet.hpp"
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+
+namespace bdd {
+	/**
+	 * @brief owns the nodes of PacketBDDs
+	 * @details nodes are hash-consed, every function over the packet bits\n
+	 * is represented by exactly one node, so equal sets have equal roots\n
+	 * results of UNION, INTERSECTION and INTERSECTION_NEGATED are memoized\n
+	 * in an operation cache that is overwritten on collisions\n
+	 * nodes are never freed before the manager is destroyed\n
+	 * a manager must only be used by a single thread
+	 */
+	class manager {
+	public:
+		using node_id = uint32_t;
+		constexpr static node_id FALSE = 0;
+		constexpr static node_id TRUE = 1;
+
+		struct node_t {
+			uint32_t var;///< bit tested by this node, terminals use PacketBDD::bits
+			node_id low;///< successor if the bit is 0
+			node_id high;///< successor if the bit is 1
+			bool operator==(const node_t&) const = default;
+		};
+		enum class Op : uint8_t {
+			AND, OR, AND_NOT
+		};
+
+		explicit manager(size_t cache_entries = 1 << 18);
+		manager(const manager&) = delete;
+		manager& operator=(const manager&) = delete;
+
+		//!@returns the node testing var, which is unique for the same successors
+		auto make(uint32_t var, node_id low, node_id high) -> node_id;
+		auto apply(Op op, node_id node1, node_id node2) -> node_id;
+		auto node(node_id id) const -> const node_t& {
+			return nodes_m[id];
+		}
+		//!@returns the amount of nodes including both terminals
+		auto nodes() const -> size_t {
+			return nodes_m.size();
+		}
+		//!@returns bytes used by the nodes, the unique table and the operation cache
+		auto memory() const -> size_t;
+
+		//!@returns the manager set by the innermost manager_scope of the calling thread
+		static auto current() -> manager&;
+	private:
+		struct node_hash {
+			auto operator()(const node_t& node) const noexcept -> size_t;
+		};
+		struct cache_entry_t {
+			node_id node1, node2, result;
+			Op op;
+			bool valid = false;
+		};
+		std::vector<node_t> nodes_m;
+		std::unordered_map<node_t,node_id,node_hash> unique_m;
+		std::vector<cache_entry_t> cache_m;
+	};
+
+	/**
+	 * @brief replaces manager::current() of the calling thread during its lifetime
+	 */
+	class manager_scope {
+	public:
+		explicit manager_scope(manager& mgr);
+		~manager_scope();
+		manager_scope(const manager_scope&) = delete;
+		manager_scope& operator=(const manager_scope&) = delete;
+	private:
+		manager* prev_m;
+	};
+}
+
+/**
+ * @brief set of packets represented as reduced ordered binary decision diagram
+ * @details an alternative to PSET, every bit of a PSegment is a variable\n
+ * ordered by dimension from the most to the least significant bit\n
+ * the size of a set depends on the structure of the contained packets\n
+ * instead of the amount of segments, negations don't fragment the set\n
+ * all sets are stored in bdd::manager::current() of the thread creating them\n
+ * and may only be combined with sets of the same manager\n
+ * in the following complexity descriptions:
+ * - @b n denotes the amount of nodes of @b this set
+ * - @b m denotes the amount of nodes of @b other set
+ * - @b s denotes the amount of segments of a PSET
+ */
+class PacketBDD {
+public:
+	//!amount of variables, the sum of the bit widths of all dimensions
+	constexpr static uint32_t bits = 2*32+2*16+3*8;
+
+	//!constructs the empty set
+	PacketBDD() = default;
+	/**
+	 * constructs the set containing the same packets as set\n
+	 * runtime O(s*bits) to build the segments plus their UNION
+	 */
+	explicit PacketBDD(const PSET& set);
+	/**
+	 * @returns the set of all packets whose dimension index lies in start to end inclusive\n
+	 * runtime O(bits)
+	 */
+	template<int index>
+	static auto range(uint64_t start, uint64_t end) -> PacketBDD;
+
+	/**
+	 * runtime O(n*m)
+	 */
+	void UNION(const PacketBDD& other);
+	void INTERSECTION(const PacketBDD& other);
+	void INTERSECTION_NEGATED(const PacketBDD& other);
+	/**
+	 * runtime O(n)
+	 */
+	void NEGATE();
+	/**
+	 * replaces the interval of dimension index of every packet with start to end\n
+	 * e.g. the destination of packets translated by DNAT\n
+	 * runtime O(n^2) in the worst case
+	 */
+	template<int index>
+	void setInterval(uint64_t start, uint64_t end);
+
+	[[nodiscard]]
+	auto isEmpty() const noexcept -> bool;
+	[[nodiscard]]
+	auto intersects(const PacketBDD& other) const -> bool;
+	[[nodiscard]]
+	auto isSubsetOf(const PacketBDD& other) const -> bool;
+	//!@returns the amount of contained packets
+	auto getAmountPoints() const -> long double;
+	//!@returns the amount of nodes reachable from this set, excluding terminals
+	auto nodes() const -> size_t;
+	//!sets are equal exactly if they contain the same packets
+	bool operator==(const PacketBDD& other) const = default;
+private:
+	explicit PacketBDD(bdd::manager::node_id root) : root_m(root) {}
+
+	bdd::manager::node_id root_m = bdd::manager::FALSE;
+};
@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+#include <rapidcheck/gtest.h>
+#include <cmath>
+#include "PacketBDD.hpp"
+#include "SegmentSet-generator.hpp"
+
+/**
+ * unions of segments with random bounds in every dimension are the worst case of a BDD\n
+ * the properties are checked on the first few segments to keep the tests fast
+ */
+PSET firstSegments(PSET set, size_t count = 4){
+	if(set.segments.size() > count)set.segments.resize(count);
+	return set;
+}
+TEST(PacketBDD,empty_and_everything){
+	PacketBDD empty;
+	PacketBDD everything(PSET{{{}}});
+	EXPECT_TRUE(empty.isEmpty());
+	EXPECT_FALSE(everything.isEmpty());
+	EXPECT_EQ(everything.nodes(),0);
+	EXPECT_EQ(everything.getAmountPoints(),std::ldexp(1.0l,PacketBDD::bits));
+	everything.NEGATE();
+	EXPECT_EQ(everything,empty);
+}
+TEST(PacketBDD,range_of_a_dimension){
+	auto ports = PacketBDD::range<PSegment::DST_PORT_INDEX>(80,443);
+	PSegment seg;
+	seg.setInterval<PSegment::DST_PORT_INDEX>(80,443);
+	EXPECT_EQ(ports,PacketBDD(PSET{{seg}}));
+	//an interval is split into at most two nodes per bit
+	EXPECT_LE(ports.nodes(),2*16);
+}
+TEST(PacketBDD,negation_doesnt_fragment){
+	PSET set;
+	for(uint32_t i = 0; i < 8; ++i){
+		PSegment seg;
+		seg.setInterval<PSegment::SRC_IP_INDEX>(i*1000,i*1000+10);
+		seg.setInterval<PSegment::DST_PORT_INDEX>(i,i);
+		set.segments.push_back(seg);
+	}
+	PacketBDD bdd(set);
+	auto negated = bdd;
+	negated.NEGATE();
+	EXPECT_EQ(negated.nodes(),bdd.nodes());
+	negated.NEGATE();
+	EXPECT_EQ(negated,bdd);
+}
+RC_GTEST_PROP(PacketBDD,operations_equal_to_PSET,(const PSET& all1, const PSET& all2)){
+	auto set1 = firstSegments(all1), set2 = firstSegments(all2);
+	PacketBDD bdd1(set1), bdd2(set2);
+	auto check = [&](auto&& op){
+		auto set = set1;
+		auto bdd = bdd1;
+		op(set,set2);
+		op(bdd,bdd2);
+		RC_ASSERT(bdd == PacketBDD(set));
+	};
+	check([](auto& s1, const auto& s2){s1.UNION(s2);});
+	check([](auto& s1, const auto& s2){s1.INTERSECTION(s2);});
+	check([](auto& s1, const auto& s2){s1.INTERSECTION_NEGATED(s2);});
+	RC_ASSERT(bdd1.isEmpty() == set1.isEmpty());
+	RC_ASSERT(bdd1.intersects(bdd2) == set1.intersects(set2));
+	RC_ASSERT(bdd1.isSubsetOf(bdd2) == set1.isSubsetOf(set2));
+}
+RC_GTEST_PROP(PacketBDD,negation_equal_to_PSET,(const PSET& all)){
+	auto set = firstSegments(all);
+	PacketBDD bdd(set);
+	bdd.NEGATE();
+	set.NEGATE_cells();
+	RC_ASSERT(bdd == PacketBDD(set));
+}
+RC_GTEST_PROP(PacketBDD,amount_of_points_equal_to_canonical_PSET,(const PSET& all)){
+	auto set = firstSegments(all);
+	set.canonicalize();
+	auto expected = set.getAmountPoints();
+	auto amount = PacketBDD(set).getAmountPoints();
+	RC_ASSERT(std::abs(amount-expected) <= expected*1e-12l);
+}
+RC_GTEST_PROP(PacketBDD,setInterval_replaces_the_dimension,(const PSET& all, uint16_t start, uint16_t end)){
+	auto set = firstSegments(all);
+	if(end < start)std::swap(start,end);
+	auto bdd = PacketBDD(set);
+	bdd.setInterval<PSegment::SRC_PORT_INDEX>(start,end);
+	for(auto& seg : set.segments){
+		seg.setInterval<PSegment::SRC_PORT_INDEX>(start,end);
+	}
+	RC_ASSERT(bdd == PacketBDD(set));
+}
@@ -0,0 +1,179 @@
+#include "PacketClasses.hpp"
+#include "util.hpp"
+#include <bit>
+#include <stdexcept>
+#include <cassert>
+
+//!@returns the smallest segment containing all packets of set
+static PSegment boundingBox(const PSET& set){
+	if(set.segments.empty())return PSegment(1,0);
+	PSegment ret = set.segments[0];
+	for(const auto& seg : set.segments){
+		util::constexpr_for<0,PSegment::dimensions,1>([&](auto dim){
+					ret.getStart<dim>() = std::min(ret.getStart<dim>(),seg.getStart<dim>());
+					ret.getEnd<dim>() = std::max(ret.getEnd<dim>(),seg.getEnd<dim>());
+				});
+	}
+	return ret;
+}
+
+PacketClasses::PacketClasses(const PacketPartition& partition)
+	: bits_m((partition.size()+63)/64), partition_m(&partition)
+{}
+void PacketClasses::adopt(const PacketClasses& other){
+	if(partition_m == nullptr)partition_m = other.partition_m;
+	if(bits_m.size() < other.bits_m.size())bits_m.resize(other.bits_m.size());
+}
+void PacketClasses::UNION(const PacketClasses& other){
+	adopt(other);
+	for(size_t i = 0; i < other.bits_m.size(); ++i)bits_m[i] |= other.bits_m[i];
+}
+void PacketClasses::INTERSECTION(const PacketClasses& other){
+	adopt(other);
+	for(size_t i = 0; i < bits_m.size(); ++i){
+		bits_m[i] &= i < other.bits_m.size() ? other.bits_m[i] : 0;
+	}
+}
+void PacketClasses::INTERSECTION_NEGATED(const PacketClasses& other){
+	adopt(other);
+	for(size_t i = 0; i < other.bits_m.size(); ++i)bits_m[i] &= ~other.bits_m[i];
+}
+void PacketClasses::NEGATE(){
+	assert(partition_m != nullptr);
+	bits_m.resize((partition_m->size()+63)/64);
+	for(auto& word : bits_m)word = ~word;
+	if(auto rest = partition_m->size()%64; rest != 0){
+		bits_m.back() &= (uint64_t{1} << rest)-1;
+	}
+}
+auto PacketClasses::isEmpty() const noexcept -> bool {
+	for(auto word : bits_m){
+		if(word != 0)return false;
+	}
+	return true;
+}
+auto PacketClasses::intersects(const PacketClasses& other) const -> bool {
+	for(size_t i = 0; i < std::min(bits_m.size(),other.bits_m.size()); ++i){
+		if((bits_m[i] & other.bits_m[i]) != 0)return true;
+	}
+	return false;
+}
+auto PacketClasses::isSubsetOf(const PacketClasses& other) const -> bool {
+	for(size_t i = 0; i < bits_m.size(); ++i){
+		uint64_t covered = i < other.bits_m.size() ? other.bits_m[i] : 0;
+		if((bits_m[i] & ~covered) != 0)return false;
+	}
+	return true;
+}
+auto PacketClasses::getAmountPoints() const -> long double {
+	long double ret = 0;
+	for(size_t i = 0; i < bits_m.size(); ++i){
+		for(uint64_t word = bits_m[i]; word != 0; word &= word-1){
+			ret += partition_m->points(i*64+std::countr_zero(word));
+		}
+	}
+	return ret;
+}
+auto PacketClasses::count() const -> size_t {
+	size_t ret = 0;
+	for(auto word : bits_m)ret += std::popcount(word);
+	return ret;
+}
+bool PacketClasses::contains(size_t id) const {
+	return id/64 < bits_m.size() && (bits_m[id/64] >> (id%64) & 1) != 0;
+}
+void PacketClasses::insert(size_t id){
+	if(id/64 >= bits_m.size())bits_m.resize(id/64+1);
+	bits_m[id/64] |= uint64_t{1} << (id%64);
+}
+bool PacketClasses::operator==(const PacketClasses& other) const {
+	return isSubsetOf(other) && other.isSubsetOf(*this);
+}
+
+PacketPartition::PacketPartition(const std::vector<const PSET*>& predicates, std::vector<translation_t> translations, size_t max_classes)
+	: max_classes_m(max_classes), manager_m(std::make_unique<bdd::manager>())
+{
+	bdd::manager_scope scope(*manager_m);
+	classes_m.push_back(PacketBDD(PSET{{{}}}));
+	bounds_m.push_back(PSegment());
+	std::vector<PacketBDD> bdd_predicates;
+	bdd_predicates.reserve(predicates.size());
+	for(const auto* predicate : predicates){
+		bdd_predicates.emplace_back(*predicate);
+		split(bdd_predicates.back(),boundingBox(*predicate));
+	}
+	//the classes are refined until the image of every class is a union of classes
+	for(bool changed = true; changed;){
+		changed = false;
+		for(const auto& translation : translations){
+			const auto& domain = bdd_predicates[translation.predicate];
+			for(size_t c = 0; c < classes_m.size(); ++c){
+				if(!classes_m[c].isSubsetOf(domain))continue;
+				auto image = classes_m[c];
+				translation.apply(image);
+				changed |= split(image,PSegment());
+			}
+		}
+	}
+
+	points_m.reserve(classes_m.size());
+	for(const auto& cls : classes_m)points_m.push_back(cls.getAmountPoints());
+	bounds_m.clear();
+	bounds_m.shrink_to_fit();
+	auto classesOf = [this](const PacketBDD& set){
+		PacketClasses ret(*this);
+		for(size_t c = 0; c < classes_m.size(); ++c){
+			if(classes_m[c].intersects(set))ret.insert(c);
+		}
+		return ret;
+	};
+	predicates_m.reserve(predicates.size());
+	for(const auto& predicate : bdd_predicates)predicates_m.push_back(classesOf(predicate));
+	for(const auto& translation : translations){
+		auto& images = images_m[translation.predicate];
+		images.resize(classes_m.size());
+		for(size_t c = 0; c < classes_m.size(); ++c){
+			if(!predicates_m[translation.predicate].contains(c))continue;
+			auto image = classes_m[c];
+			translation.apply(image);
+			images[c] = classesOf(image);
+		}
+	}
+}
+bool PacketPartition::split(const PacketBDD& predicate, const PSegment& bounds){
+	bool ret = false;
+	if(bounds.empty())return ret;
+	for(size_t c = 0, size = classes_m.size(); c < size; ++c){
+		//most classes are far away from a predicate, comparing their bounds is cheaper than intersecting them
+		if(!bounds_m[c].overlaps(bounds))continue;
+		auto inside = classes_m[c];
+		inside.INTERSECTION(predicate);
+		if(inside.isEmpty() || inside == classes_m[c])continue;
+		if(classes_m.size() >= max_classes_m){
+			throw std::length_error("the packets are split into too many classes");
+		}
+		classes_m[c].INTERSECTION_NEGATED(predicate);
+		classes_m.push_back(std::move(inside));
+		bounds_m.push_back(intersect(bounds_m[c],bounds));
+		ret = true;
+	}
+	return ret;
+}
+auto PacketPartition::classesOf(const PSET& set) const -> PacketClasses {
+	std::lock_guard lock(manager_mutex_m);
+	bdd::manager_scope scope(*manager_m);
+	PacketBDD bdd(set);
+	PacketClasses ret(*this);
+	for(size_t c = 0; c < classes_m.size(); ++c){
+		if(classes_m[c].intersects(bdd))ret.insert(c);
+	}
+	return ret;
+}
+auto PacketPartition::translate(const PacketClasses& set, size_t predicate) const -> PacketClasses {
+	const auto& images = images_m.at(predicate);
+	PacketClasses ret(*this);
+	for(size_t c = 0; c < classes_m.size(); ++c){
+		if(set.contains(c))ret.UNION(images[c]);
+	}
+	return ret;
+}
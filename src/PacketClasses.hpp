@@ -0,0 +1,128 @@
+#pragma once
+#include "PacketBDD.hpp"
+#include <cstdint>
+#include <vector>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+class PacketPartition;
+/**
+ * @brief set of packets represented as the set of ids of the packet classes it contains
+ * @details only sets that are unions of classes of the PacketPartition can be represented\n
+ * every operation is a bitwise operation on the ids\n
+ * a default constructed set is empty and takes the partition of the first set it is combined with\n
+ * in the following complexity descriptions:
+ * - @b c denotes the amount of classes of the partition
+ */
+class PacketClasses {
+public:
+	PacketClasses() = default;
+	//!constructs the empty set of partition
+	explicit PacketClasses(const PacketPartition& partition);
+
+	/**
+	 * runtime O(c)
+	 */
+	void UNION(const PacketClasses& other);
+	void INTERSECTION(const PacketClasses& other);
+	void INTERSECTION_NEGATED(const PacketClasses& other);
+	void NEGATE();
+
+	[[nodiscard]]
+	auto isEmpty() const noexcept -> bool;
+	[[nodiscard]]
+	auto intersects(const PacketClasses& other) const -> bool;
+	[[nodiscard]]
+	auto isSubsetOf(const PacketClasses& other) const -> bool;
+	//!@returns the amount of contained packets
+	auto getAmountPoints() const -> long double;
+	//!@returns the amount of contained classes
+	auto count() const -> size_t;
+	bool contains(size_t id) const;
+	void insert(size_t id);
+	auto partition() const -> const PacketPartition* {
+		return partition_m;
+	}
+	bool operator==(const PacketClasses& other) const;
+private:
+	//!takes the partition of other and grows to its size
+	void adopt(const PacketClasses& other);
+
+	std::vector<uint64_t> bits_m;///< bit i is set if class i is contained
+	const PacketPartition* partition_m = nullptr;
+};
+
+/**
+ * @brief the atomic predicates of a collection of packet sets
+ * @details the packets are partitioned into the coarsest classes, such that every predicate\n
+ * is a union of classes, so every combination of predicates by set operations is one as well\n
+ * translations (e.g. NAT) are supported by refining the classes until the image of every class\n
+ * of the domain of a translation is a union of classes\n
+ * the classes are computed as PacketBDDs in a bdd::manager owned by the partition\n
+ * in the following complexity descriptions:
+ * - @b c denotes the amount of classes
+ * - @b p denotes the amount of predicates
+ */
+class PacketPartition {
+public:
+	/**
+	 * @brief a function applied to the packets of predicate
+	 */
+	struct translation_t {
+		size_t predicate;///<index of the predicate the translation is applied to
+		std::function<void(PacketBDD&)> apply;
+	};
+	constexpr static size_t default_max_classes = 1 << 16;
+
+	/**
+	 * computes the classes of predicates\n
+	 * runtime O(p*c) PacketBDD operations plus O(c^2) per refinement by a translation
+	 * @throws std::length_error if there are more than max_classes classes
+	 */
+	PacketPartition(const std::vector<const PSET*>& predicates, std::vector<translation_t> translations, size_t max_classes = default_max_classes);
+	PacketPartition(const PacketPartition&) = delete;
+	PacketPartition& operator=(const PacketPartition&) = delete;
+
+	//!@returns the amount of classes
+	auto size() const -> size_t {
+		return points_m.size();
+	}
+	//!@returns the classes of the index'th predicate
+	auto predicate(size_t index) const -> const PacketClasses& {
+		return predicates_m[index];
+	}
+	//!@returns the amount of packets of class id
+	auto points(size_t id) const -> long double {
+		return points_m[id];
+	}
+	/**
+	 * @returns the classes intersecting set, which contain the same packets if set is a union of classes\n
+	 * can be called by multiple threads concurrently\n
+	 * runtime O(c) PacketBDD operations
+	 */
+	auto classesOf(const PSET& set) const -> PacketClasses;
+	/**
+	 * @returns the image of the translation of the predicate with index predicate\n
+	 * set must be a subset of the predicate\n
+	 * runtime O(c^2/64)
+	 */
+	auto translate(const PacketClasses& set, size_t predicate) const -> PacketClasses;
+private:
+	/**
+	 * splits every class into the packets inside and outside of predicate
+	 * @param bounds contains all packets of predicate
+	 * @returns whether a class was split
+	 */
+	bool split(const PacketBDD& predicate, const PSegment& bounds);
+
+	size_t max_classes_m;
+	std::unique_ptr<bdd::manager> manager_m;
+	mutable std::mutex manager_mutex_m;///<guards manager_m after the construction
+	std::vector<PacketBDD> classes_m;
+	std::vector<PSegment> bounds_m;///<contain the packets of the classes, only during the construction
+	std::vector<long double> points_m;
+	std::vector<PacketClasses> predicates_m;
+	//!images of the classes by the translations of a predicate, empty for classes outside of it
+	std::unordered_map<size_t,std::vector<PacketClasses>> images_m;
+};
@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+#include <rapidcheck/gtest.h>
+#include <stdexcept>
+#include "PacketClasses.hpp"
+#include "SegmentSet-generator.hpp"
+
+PSET sourceRange(uint32_t start, uint32_t end){
+	PSegment seg;
+	seg.setInterval<PSegment::SRC_IP_INDEX>(start,end);
+	return PSET{{seg}};
+}
+TEST(PacketPartition,overlapping_predicates){
+	auto set1 = sourceRange(0,99), set2 = sourceRange(50,149);
+	PacketPartition partition({&set1,&set2},{});
+	//0-49, 50-99, 100-149 and everything else
+	EXPECT_EQ(partition.size(),4);
+	EXPECT_EQ(partition.predicate(0).count(),2);
+	EXPECT_TRUE(partition.predicate(0).intersects(partition.predicate(1)));
+	EXPECT_FALSE(partition.predicate(0).isSubsetOf(partition.predicate(1)));
+
+	auto both = partition.predicate(0);
+	both.INTERSECTION(partition.predicate(1));
+	EXPECT_EQ(both,partition.classesOf(sourceRange(50,99)));
+	EXPECT_EQ(both.getAmountPoints(),sourceRange(50,99).getAmountPoints());
+
+	auto rest = partition.predicate(0);
+	rest.UNION(partition.predicate(1));
+	rest.NEGATE();
+	EXPECT_EQ(rest.count(),1);
+	EXPECT_FALSE(rest.intersects(partition.predicate(1)));
+}
+TEST(PacketPartition,images_of_translations_are_classes){
+	//packets of set1 are translated to the sources 1000-1099, which are split by set2
+	auto set1 = sourceRange(0,99), set2 = sourceRange(1050,1149);
+	auto translate = [](PacketBDD& set){
+		set.setInterval<PSegment::SRC_IP_INDEX>(1000,1099);
+	};
+	PacketPartition partition({&set1,&set2},{{0,translate}});
+	auto image = partition.translate(partition.predicate(0),0);
+	EXPECT_EQ(image,partition.classesOf(sourceRange(1000,1099)));
+	EXPECT_EQ(image.getAmountPoints(),sourceRange(1000,1099).getAmountPoints());
+}
+TEST(PacketPartition,too_many_classes){
+	std::vector<PSET> sets;
+	for(uint32_t i = 0; i < 8; ++i)sets.push_back(sourceRange(i*10,i*10+5));
+	std::vector<const PSET*> predicates;
+	for(const auto& set : sets)predicates.push_back(&set);
+	EXPECT_THROW(PacketPartition(predicates,{},4),std::length_error);
+	EXPECT_EQ(PacketPartition(predicates,{},9).size(),9);
+}
+RC_GTEST_PROP(PacketPartition,operations_equal_to_PSET,(const PSET& all1, const PSET& all2)){
+	//unions of segments with random bounds are the worst case of the BDDs the classes are computed with
+	auto set1 = all1, set2 = all2;
+	if(set1.segments.size() > 3)set1.segments.resize(3);
+	if(set2.segments.size() > 3)set2.segments.resize(3);
+	PacketPartition partition({&set1,&set2},{});
+	const auto& classes1 = partition.predicate(0);
+	const auto& classes2 = partition.predicate(1);
+	auto check = [&](auto&& op){
+		auto set = set1;
+		auto classes = classes1;
+		op(set,set2);
+		op(classes,classes2);
+		RC_ASSERT(classes == partition.classesOf(set));
+	};
+	check([](auto& s1, const auto& s2){s1.UNION(s2);});
+	check([](auto& s1, const auto& s2){s1.INTERSECTION(s2);});
+	check([](auto& s1, const auto& s2){s1.INTERSECTION_NEGATED(s2);});
+	RC_ASSERT(classes1.isEmpty() == set1.isEmpty());
+	RC_ASSERT(classes1.intersects(classes2) == set1.intersects(set2));
+	RC_ASSERT(classes1.isSubsetOf(classes2) == set1.isSubsetOf(set2));
+}
@@ -0,0 +1,159 @@
+#include "PrefixTrie.hpp"
+#include <bit>
+#include <algorithm>
+
+static uint32_t mask(int length){
+	return length == 0 ? 0 : ~uint32_t{0} << (32-length);
+}
+//!@returns the bit of prefix at position, 0 is the most significant bit
+static int bitAt(uint32_t prefix, int position){
+	return (prefix >> (31-position)) & 1;
+}
+//!@returns the amount of leading bits prefix1 and prefix2 have in common, at most max
+static int commonLength(uint32_t prefix1, uint32_t prefix2, int max){
+	return std::min(std::countl_zero(prefix1 ^ prefix2),max);
+}
+
+PrefixTrie::PrefixTrie(uint32_t start, uint32_t end){
+	insert({start,end});
+}
+PrefixTrie::PrefixTrie(const PrefixTrie& other) : root_m(clone(other.root_m.get())) {}
+PrefixTrie& PrefixTrie::operator=(const PrefixTrie& other){
+	if(this != &other)root_m = clone(other.root_m.get());
+	return *this;
+}
+
+void PrefixTrie::insert(uint32_t prefix, int length){
+	root_m = insert(std::move(root_m),prefix & mask(length),length);
+}
+void PrefixTrie::insert(range_t range){
+	uint64_t start = range.first;
+	uint64_t end = range.second;
+	while(start <= end){
+		//the largest aligned block starting at start that doesn't exceed end
+		uint64_t size = start == 0 ? uint64_t{1} << 32 : start & -start;
+		while(start+size-1 > end)size >>= 1;
+		insert(static_cast<uint32_t>(start),32-std::countr_zero(size));
+		start += size;
+	}
+}
+auto PrefixTrie::insert(node_ptr node, uint32_t prefix, int length) -> node_ptr {
+	if(!node){
+		return node_ptr(new node_t{prefix,length,true,{}});
+	}
+	int common = commonLength(node->prefix,prefix,std::min(node->length,length));
+	if(common < node->length){
+		if(common == length){
+			//the new prefix covers the whole subtree
+			return insert(nullptr,prefix,length);
+		}
+		auto leaf = insert(nullptr,prefix,length);
+		if(bitAt(prefix,common) == 0){
+			return join(prefix & mask(common),common,std::move(leaf),std::move(node));
+		}
+		return join(prefix & mask(common),common,std::move(node),std::move(leaf));
+	}
+	if(node->full)return node;
+	if(length == node->length){
+		return insert(nullptr,prefix,length);
+	}
+	auto& child = node->children[bitAt(prefix,node->length)];
+	child = insert(std::move(child),prefix,length);
+	return join(node->prefix,node->length,std::move(node->children[0]),std::move(node->children[1]));
+}
+auto PrefixTrie::join(uint32_t prefix, int length, node_ptr child0, node_ptr child1) -> node_ptr {
+	if(!child0)return child1;
+	if(!child1)return child0;
+	if(child0->full && child1->full && child0->length == length+1 && child1->length == length+1){
+		return insert(nullptr,prefix,length);
+	}
+	return node_ptr(new node_t{prefix,length,false,{std::move(child0),std::move(child1)}});
+}
+auto PrefixTrie::clone(const node_t* node) -> node_ptr {
+	if(node == nullptr)return nullptr;
+	return node_ptr(new node_t{node->prefix,node->length,node->full,{
+				clone(node->children[0].get()),
+				clone(node->children[1].get())}});
+}
+
+auto PrefixTrie::intersect(const PrefixTrie& other) const -> PrefixTrie {
+	PrefixTrie ret;
+	ret.root_m = intersect(root_m.get(),other.root_m.get());
+	return ret;
+}
+auto PrefixTrie::intersect(const node_t* node1, const node_t* node2) -> node_ptr {
+	if(node1 == nullptr || node2 == nullptr)return nullptr;
+	if(node1->length > node2->length)std::swap(node1,node2);
+	if(commonLength(node1->prefix,node2->prefix,node1->length) < node1->length){
+		return nullptr;
+	}
+	//node1 is a prefix of node2
+	if(node1->full)return clone(node2);
+	if(node1->length == node2->length){
+		if(node2->full)return clone(node1);
+		return join(node1->prefix,node1->length,
+				intersect(node1->children[0].get(),node2->children[0].get()),
+				intersect(node1->children[1].get(),node2->children[1].get()));
+	}
+	return intersect(node1->children[bitAt(node2->prefix,node1->length)].get(),node2);
+}
+
+bool PrefixTrie::contains(uint32_t ip) const {
+	const node_t* node = root_m.get();
+	while(node != nullptr){
+		if(commonLength(node->prefix,ip,node->length) < node->length)return false;
+		if(node->full)return true;
+		node = node->children[bitAt(ip,node->length)].get();
+	}
+	return false;
+}
+auto PrefixTrie::ranges() const -> std::vector<range_t> {
+	std::vector<range_t> ret;
+	std::vector<const node_t*> stack;
+	if(root_m)stack.push_back(root_m.get());
+	while(!stack.empty()){
+		const node_t* node = stack.back();
+		stack.pop_back();
+		if(!node->full){
+			stack.push_back(node->children[1].get());
+			stack.push_back(node->children[0].get());
+			continue;
+		}
+		uint32_t start = node->prefix;
+		uint32_t end = node->prefix | ~mask(node->length);
+		if(!ret.empty() && ret.back().second+uint64_t{1} == start){
+			ret.back().second = end;
+		}else{
+			ret.emplace_back(start,end);
+		}
+	}
+	return ret;
+}
+bool PrefixTrie::empty() const {
+	return root_m == nullptr;
+}
+auto PrefixTrie::nodes() const -> size_t {
+	size_t ret = 0;
+	std::vector<const node_t*> stack;
+	if(root_m)stack.push_back(root_m.get());
+	while(!stack.empty()){
+		const node_t* node = stack.back();
+		stack.pop_back();
+		ret++;
+		for(const auto& child : node->children){
+			if(child)stack.push_back(child.get());
+		}
+	}
+	return ret;
+}
+bool PrefixTrie::operator==(const PrefixTrie& other) const {
+	return equal(root_m.get(),other.root_m.get());
+}
+bool PrefixTrie::equal(const node_t* node1, const node_t* node2){
+	if(node1 == nullptr || node2 == nullptr)return node1 == node2;
+	return node1->prefix == node2->prefix
+		&& node1->length == node2->length
+		&& node1->full == node2->full
+		&& equal(node1->children[0].get(),node2->children[0].get())
+		&& equal(node1->children[1].get(),node2->children[1].get());
+}
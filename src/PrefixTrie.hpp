@@ -0,0 +1,75 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <utility>
+
+/**
+ * @brief set of IPv4 addresses stored as CIDR prefixes in a path compressed binary trie
+ * @details every node is a prefix, a node is either full (all addresses\n
+ * of the prefix are contained) or has two children that extend its prefix\n
+ * by at least one bit, so only prefixes where the set branches are stored\n
+ * prefixes covered by a full one are dropped and two full siblings are merged\n
+ * into their parent, two tries containing the same addresses are equal\n
+ * in the following complexity descriptions:
+ * - @b n denotes the amount of nodes in @b this trie
+ * - @b m denotes the amount of nodes in @b other trie
+ */
+class PrefixTrie {
+public:
+	using range_t = std::pair<uint32_t,uint32_t>;
+
+	PrefixTrie() = default;
+	//!contains the addresses from start to end inclusive
+	PrefixTrie(uint32_t start, uint32_t end);
+	PrefixTrie(const PrefixTrie& other);
+	PrefixTrie(PrefixTrie&&) = default;
+	PrefixTrie& operator=(const PrefixTrie& other);
+	PrefixTrie& operator=(PrefixTrie&&) = default;
+
+	/**
+	 * adds all addresses of prefix/length\n
+	 * runtime O(32)
+	 */
+	void insert(uint32_t prefix, int length);
+	/**
+	 * adds the addresses from range.first to range.second inclusive\n
+	 * the range is split into at most 62 prefixes\n
+	 * runtime O(32*62)
+	 */
+	void insert(range_t range);
+	/**
+	 * @returns the addresses contained in both tries\n
+	 * runtime O(n+m)
+	 */
+	auto intersect(const PrefixTrie& other) const -> PrefixTrie;
+	/**
+	 * runtime O(32)
+	 */
+	bool contains(uint32_t ip) const;
+	/**
+	 * @returns the contained addresses as sorted, disjoint and non adjacent ranges\n
+	 * runtime O(n)
+	 */
+	auto ranges() const -> std::vector<range_t>;
+	bool empty() const;
+	//!@returns the amount of nodes
+	auto nodes() const -> size_t;
+	bool operator==(const PrefixTrie& other) const;
+private:
+	struct node_t {
+		uint32_t prefix;///< the bits after length are zero
+		int length;
+		bool full;
+		std::unique_ptr<node_t> children[2];
+	};
+	using node_ptr = std::unique_ptr<node_t>;
+
+	static auto insert(node_ptr node, uint32_t prefix, int length) -> node_ptr;
+	static auto intersect(const node_t* node1, const node_t* node2) -> node_ptr;
+	static auto join(uint32_t prefix, int length, node_ptr child0, node_ptr child1) -> node_ptr;
+	static auto clone(const node_t* node) -> node_ptr;
+	static bool equal(const node_t* node1, const node_t* node2);
+
+	node_ptr root_m;
+};
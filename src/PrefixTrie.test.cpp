@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+#include <rapidcheck/gtest.h>
+#include "PrefixTrie.hpp"
+#include <algorithm>
+
+using ranges_t = std::vector<PrefixTrie::range_t>;
+
+//!@returns the ranges sorted and with overlapping or adjacent ones merged
+static ranges_t normalize(ranges_t ranges){
+	std::ranges::sort(ranges);
+	ranges_t ret;
+	for(auto range : ranges){
+		if(!ret.empty() && range.first <= ret.back().second+uint64_t{1}){
+			ret.back().second = std::max(ret.back().second,range.second);
+		}else{
+			ret.push_back(range);
+		}
+	}
+	return ret;
+}
+//!orders the bounds of arbitrary pairs
+static ranges_t toRanges(ranges_t pairs){
+	for(auto& [start,end] : pairs){
+		if(start > end)std::swap(start,end);
+	}
+	return pairs;
+}
+
+TEST(PrefixTrie,adjacent_prefixes_are_merged){
+	PrefixTrie trie;
+	for(uint32_t ip = 0; ip < 256; ++ip){
+		trie.insert(0x0a000000 | ip,32);
+	}
+	EXPECT_EQ(trie.nodes(),1);
+	EXPECT_EQ(trie.ranges(),(ranges_t{{0x0a000000,0x0a0000ff}}));
+	trie.insert(0x0a000000,8);
+	EXPECT_EQ(trie.ranges(),(ranges_t{{0x0a000000,0x0affffff}}));
+	trie.insert({0,0xffffffff});
+	EXPECT_EQ(trie.nodes(),1);
+	EXPECT_TRUE(trie.contains(0));
+}
+TEST(PrefixTrie,intersection_of_prefixes){
+	PrefixTrie trie1, trie2;
+	trie1.insert(0x0a000000,8);
+	trie1.insert(0xc0a80000,16);
+	trie2.insert(0x0a010000,16);
+	trie2.insert(0xc0000000,8);
+	EXPECT_EQ(trie1.intersect(trie2).ranges(),(ranges_t{{0x0a010000,0x0a01ffff},{0xc0a80000,0xc0a8ffff}}));
+	EXPECT_TRUE(trie1.intersect(PrefixTrie()).empty());
+}
+RC_GTEST_PROP(PrefixTrie,ranges_are_the_inserted_ranges,(const ranges_t& pairs)){
+	auto inserted = toRanges(pairs);
+	PrefixTrie trie;
+	for(auto range : inserted)trie.insert(range);
+	RC_ASSERT(trie.ranges() == normalize(inserted));
+	for(auto [start,end] : inserted){
+		RC_ASSERT(trie.contains(start));
+		RC_ASSERT(trie.contains(end));
+	}
+}
+RC_GTEST_PROP(PrefixTrie,equal_for_equal_addresses,(const ranges_t& pairs)){
+	auto inserted = toRanges(pairs);
+	PrefixTrie trie1, trie2;
+	for(auto range : inserted)trie1.insert(range);
+	std::ranges::reverse(inserted);
+	for(auto range : inserted)trie2.insert(range);
+	RC_ASSERT(trie1 == trie2);
+}
+RC_GTEST_PROP(PrefixTrie,intersect_equal_to_range_intersection,(const ranges_t& pairs1, const ranges_t& pairs2)){
+	auto ranges1 = toRanges(pairs1);
+	auto ranges2 = toRanges(pairs2);
+	PrefixTrie trie1, trie2;
+	for(auto range : ranges1)trie1.insert(range);
+	for(auto range : ranges2)trie2.insert(range);
+	ranges_t expected;
+	for(auto [start1,end1] : normalize(ranges1)){
+		for(auto [start2,end2] : normalize(ranges2)){
+			if(std::max(start1,start2) <= std::min(end1,end2)){
+				expected.emplace_back(std::max(start1,start2),std::min(end1,end2));
+			}
+		}
+	}
+	RC_ASSERT(trie1.intersect(trie2).ranges() == normalize(expected));
+	RC_ASSERT(trie1.intersect(trie2) == trie2.intersect(trie1));
+}
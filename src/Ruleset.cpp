@@ -14,12 +14,7 @@ void Ruleset::resetRules(){
 	);
 }
 void Rule::reset(){
-	touched = false;
-	aliveMatch = 0;
-	deadMatch = 0;
-	aliveJump = 0;
-	deadJump = 0;
-	matched = 0;
+	counters = {};
 }
 bool Chain::isDropping() const{
 	return special == Special::DROP || special == Special::REJECT;
@@ -4,6 +4,7 @@
 #include <memory>
 #include <array>
 #include <set>
+#include "util.hpp"
 
 constexpr auto RAW_TABLE = "raw";
 constexpr auto MANGLE_TABLE = "mangle";
@@ -46,7 +47,8 @@ public:
 	
 	//! individual ranges of propertys that are matched by flags\n
 	//! used to check if rules are \link mergeable
-	std::array<std::set<std::pair<uint32_t,uint32_t>>,MatchingFlag::_SIZE> flag_segments = {};
+	using flag_segments_t = std::array<util::cow_set<std::pair<uint32_t,uint32_t>>,MatchingFlag::_SIZE>;
+	flag_segments_t flag_segments = {};
 
 	//! ptr to chain in a Ruleset. corresponds to the Chain after -j or -g flag
 	Chain* jumpTarget = nullptr;
@@ -78,12 +80,17 @@ public:
 
 
 	//data used when analyzing
-	bool touched = false;
-	long double matched = 0;
-	int aliveMatch = 0;
-	int deadMatch = 0;
-	int aliveJump = 0;
-	int deadJump = 0;
+	struct counters_t {
+		bool touched = false;
+		long double matched = 0;
+		int aliveMatch = 0;
+		int deadMatch = 0;
+		int aliveJump = 0;
+		int deadJump = 0;
+		bool operator==(const counters_t&) const = default;
+	};
+	counters_t counters;///<counters of the dead rule analysis
+	size_t id = 0;///<position in Ruleset::forEachRule order, indexes the counters of a single pipe run
 
 	//this data can be reseted with the [reset] function
 	void reset();
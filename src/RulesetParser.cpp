@@ -4,79 +4,62 @@
 #include <functional>
 #include <fstream>
 #include <sstream>
+#include <iterator>
 #include <tuple>
+#include <exception>
+#include <algorithm>
 #include "args.hpp"
 #include "util.hpp"
 #include "parser/common.hpp"
 
-bool parseNot(std::istream& in){
-	parseWhitespace(in);
-	if(in.peek() == '!'){
-		in.get();
-		return true;
-	}
-	return false;
+static bool parseNot(try_parser& in){
+	in.ws();
+	return in.matchStaticString("!");
 }
-std::string parseArg(std::istream& in){
-	parseWhitespace(in);
-	char c = in.peek();
-	bool stringMode = false;
-	if ( c == '\"' )stringMode = true;
-	if(stringMode){
-		std::ostringstream oss;
-		oss << c;
-		in.get();
-		c = 0;
-		while(c != '\"'){
-			c = in.get();
-			oss << c;
-		}
-		return oss.str();
-	}else{
-		std::string ret;
-		in >> ret;
-		return ret;
-	}
+//!reads the next whitespace separated or quoted argument
+static std::string_view parseArg(try_parser& in){
+	in.ws();
+	return in.string();
 }
 
 
 Table& RulesetParser::curTable(){
 	return tables.back();
 }
-Chain& RulesetParser::getChainOrCreate(const std::string& name){
-	auto& chain_uptr = chains[name];
-	if(chain_uptr.get() == nullptr){
-		chain_uptr = std::make_unique<Chain>();
-		chain_uptr->name = name;
-		chain_uptr->line = line;
+Chain& RulesetParser::getChainOrCreate(table_state_t& state, std::string_view name){
+	auto& chains = state.chains;
+	auto iter = chains.find(name);
+	if(iter == std::end(chains)){
+		iter = chains.emplace(name,std::make_unique<Chain>()).first;
+		iter->second->name = name;
+		iter->second->line = state.line;
 	}
-	return *chain_uptr.get();
+	return *iter->second.get();
+}
+auto RulesetParser::index(util::indexer<std::string,uint8_t>& indexer, std::string_view name) -> uint8_t {
+	std::lock_guard lock(index_mutex);
+	return indexer[name];
 }
 
-void RulesetParser::parseRule(std::istream& in, std::string line_str){
+void RulesetParser::parseRule(table_state_t& state, try_parser& in, std::string_view line_str){
+	const int line = state.line;
 	Rule ret;
 	ret.line_str = line_str;
 
-	parseWhitespace(in);
-	std::string chain_name;
-	in >> chain_name;
+	auto chain_name = parseArg(in);
 
 	PSET result = PSET(bor::vector{PSegment{}});
 
 
-	while(!in.eof()){
-		parseWhitespace(in);
+	while(true){
 		bool prefixNot = parseNot(in);
-		parseWhitespace(in);
-		char c = in.get();
-		if(in.eof())break;
-		if(c != '-'){
-			throw std::runtime_error(fmt::format("unexpected {} in line {}",c,line));
+		in.ws();
+		if(in.done())break;
+		if(!in.matchStaticString("-")){
+			throw std::runtime_error(fmt::format("unexpected {} in line {}",in.string(),line));
 		}
-		c = in.peek();
-		if(c == '-')in.get();
-		std::string flag_name;
-		in >> flag_name;
+		in.matchStaticString("-");
+		auto flag_name = in.string();
 		bool negation = parseNot(in)^prefixNot;
 		if(args::config.disable.rules.with_flags.contains(flag_name) && 
 				args::config.disable.rules.with_flags[flag_name] == std::nullopt){
@@ -84,25 +67,18 @@ void RulesetParser::parseRule(std::istream& in, std::string line_str){
 		}
 
 		if(flag_name == "g" || flag_name == "j"){
-			std::string jump_target_name;
-			in >> jump_target_name;
-			ret.jumpTarget = &getChainOrCreate(jump_target_name);
+			ret.jumpTarget = &getChainOrCreate(state,parseArg(in));
 			if(flag_name == "g"){
 				ret.jumpType = JumpType::GOTO;
 			}else{
 				ret.jumpType = JumpType::JUMP;
 			}
 		}else if(flag_name == "match-set"){
-			std::string set_name;
-			in >> set_name;
-			parseWhitespace(in);
-			std::string flags;
-			in >> flags;
-			ip_sets.get(set_name)->apply(ret,result,flags);
-		}else if(flag_name.find("port") != std::string::npos){
-			std::string port_list;
-			in >> port_list;
-			auto port_ranges = parsePortList(port_list);
+			auto set_name = parseArg(in);
+			auto flags = parseArg(in);
+			ip_sets.get(std::string{set_name})->apply(ret,result,flags);
+		}else if(flag_name.find("port") != std::string_view::npos){
+			auto port_ranges = parsePortList(parseArg(in));
 			if(flag_name == "ports"){
 				result.applyRange_helper<PSegment::SRC_PORT_INDEX>(port_ranges,negation);
 				result.applyRange_helper<PSegment::DST_PORT_INDEX>(port_ranges,negation);
@@ -116,12 +92,11 @@ void RulesetParser::parseRule(std::istream& in, std::string line_str){
 				ret.flag_segments[Rule::DST_PORT].insert(std::begin(port_ranges),std::end(port_ranges));
 			}
 		}else if(flag_name == "i" || flag_name == "o"){
-			std::string interface;
-			in >> interface;
+			auto interface = parseArg(in);
 
 			auto& interface_map = (flag_name == "i" ? in_interfaces : out_interfaces);
 
-			auto value = interface_map[interface];
+			auto value = index(interface_map,interface);
 			if(flag_name == "i"){
 				result.applyRange_helper<PSegment::IN_INTERFACE_INDEX>(std::vector{std::pair{value,value}},negation);
 				ret.flag_segments[Rule::IN_INTERFACE].emplace(value,value);
@@ -130,52 +105,49 @@ void RulesetParser::parseRule(std::istream& in, std::string line_str){
 				ret.flag_segments[Rule::OUT_INTERFACE].emplace(value,value);
 			}
 		}else if(flag_name == "p"){
-			std::string interface;
-			in >> interface;
-			auto value = protocols[interface];
+			auto value = index(protocols,parseArg(in));
 			result.applyRange_helper<PSegment::PROTOCOL_INDEX>(std::vector{std::pair{value,value}},negation);
 			ret.flag_segments[Rule::PROTOCOL].emplace(value,value);
 		}else if(flag_name == "d"){
-			auto [start,end] = parseIP(in,line);
+			auto [start,end] = parseIP(parseArg(in),line);
 			result.applyRange_helper<PSegment::DST_IP_INDEX>(std::vector{std::pair{start,end}},negation);
 			ret.flag_segments[Rule::DST_IP].emplace(start,end);
 		}else if(flag_name == "s") {
-			auto [start,end] = parseIP(in,line);
+			auto [start,end] = parseIP(parseArg(in),line);
 			result.applyRange_helper<PSegment::SRC_IP_INDEX>(std::vector{std::pair{start,end}},negation);
 			ret.flag_segments[Rule::SRC_IP].emplace(start,end);
 		}else if(flag_name == "to-destination" || flag_name == "to-source"){
-			auto [start_ip,end_ip] = parseIP(in,line);
-			if(in.peek() == '-'){
-				in.get();
-				end_ip = parseIP(in,line).first;
+			//[ip[-ip]][:port[-port]]
+			auto target = parseArg(in);
+			auto colon = target.find(':');
+			auto ips = target.substr(0,colon);
+			auto dash = ips.find('-');
+			auto [start_ip,end_ip] = parseIP(ips.substr(0,dash),line);
+			if(dash != std::string_view::npos){
+				end_ip = parseIP(ips.substr(dash+1),line).first;
 			}
 			bool port_change = false;
-			uint16_t start_port,end_port;
-			if(in.peek() == ':'){
+			uint16_t start_port = 0, end_port = 0;
+			if(colon != std::string_view::npos){
 				port_change = true;
-				in.get();
-				in >> start_port;
-				if(in.peek() == '-'){
-					in.get();
-					in >> end_port;
-				}else{
-					end_port = start_port;
-				}
+				auto ports = target.substr(colon+1);
+				auto port_dash = ports.find('-');
+				start_port = toInt<uint16_t>(ports.substr(0,port_dash));
+				end_port = port_dash == std::string_view::npos ? start_port : toInt<uint16_t>(ports.substr(port_dash+1));
 			}
 			ret.nat = {start_ip,end_ip,port_change,start_port,end_port};
 		}else if(flag_name == "restore-mark"){
 		}else if(flag_name == "m"){
-			std::string s;
-			in >> s;
+			parseArg(in);
 			parseNot(in);
 		}else if(flag_name == "ctstate"){
 			mlog::debug("unsupported flag ctstate ignoring rule on line {}\n",line);
-			results.unknownFlags.insert(flag_name);
+			state.results.unknownFlags.emplace(flag_name);
 			parseArg(in);
 			ret.shouldBeIgnored = true;
 		}else if(flag_name == "tcp-flags"){
 			mlog::debug("unsupported flag tcp-flags ignoring rule on line {}\n",line);
-			results.unknownFlags.insert(flag_name);
+			state.results.unknownFlags.emplace(flag_name);
 			parseArg(in);
 			parseArg(in);
 			ret.shouldBeIgnored = true;
@@ -199,14 +171,14 @@ void RulesetParser::parseRule(std::istream& in, std::string line_str){
 				}
 				mlog::debug("unrecognized flag \"{}\" with arguments \'{}\'\n", flag_name, args);
 			}
-			results.unknownFlags.insert(flag_name);
+			state.results.unknownFlags.emplace(flag_name);
 		}
 	}
 
 	if(ret.jumpTarget == nullptr){
 		mlog::debug("rule without jumptarget on line {}, will be ignored: {}\n",line,ret.line_str);
 		if(!args::config.silence.no_jump_target.contains(chain_name)){
-			results.rulesWithoutJumpTarget.push_back(line);
+			state.results.rulesWithoutJumpTarget.push_back(line);
 		}
 		ret.shouldBeIgnored = true;
 	}else{
@@ -214,33 +186,24 @@ void RulesetParser::parseRule(std::istream& in, std::string line_str){
 			ret.shouldBeIgnored = true;
 		}
 	}
-	ret.table_name = curTable().name;
 	ret.maximumMatchingSet = std::move(result);
 	ret.line = line;
-	getChainOrCreate(chain_name).rules.emplace_back(std::move(ret));
+	getChainOrCreate(state,chain_name).rules.emplace_back(std::move(ret));
 }
-void RulesetParser::parseTable(std::istream& in, std::string&& table_name){
-
-
-	tables.emplace_back();
-	curTable().name = std::move(table_name);
-
-	std::string line;
-	while(true){
-		std::getline(in,line);
-		if(in.eof() && line.empty())break;
-		this->line++;
-		if(line == "COMMIT")break;
-
-		std::stringstream line_in(line);
-		
-		char c = line_in.get();
+void RulesetParser::parseTable(table_state_t& state, std::string_view text){
+	try_parser lines(text);
+	//a single parser is pointed at every line of the table
+	try_parser line_in{""};
+	while(!lines.done()){
+		auto line = lines.line();
+		state.line++;
+
+		line_in.setInput(line);
 		bool parsed = false;
-		if(c == ':'){
-			std::string chain_name;
-			std::string policy;
-			line_in >> chain_name >> policy;
-			Chain& chain = getChainOrCreate(chain_name);
+		if(line_in.matchStaticString(":")){
+			auto chain_name = line_in.string();
+			auto policy = parseArg(line_in);
+			Chain& chain = getChainOrCreate(state,chain_name);
 			if(policy == "ACCEPT")chain.policy = Chain::Policy::ACCEPT;
 			else if(policy == "DROP")chain.policy = Chain::Policy::DROP;
 			else if(policy == "-")chain.policy = Chain::Policy::NONE;
@@ -248,31 +211,27 @@ void RulesetParser::parseTable(std::istream& in, std::string&& table_name){
 				mlog::log("unrecognized chain policy \"{}\"\n",policy);
 			}
 			parsed = true;
-		} else if(c == '-'){
-			line_in >> c;
-			if(c == 'A'){
-				parseRule(line_in,line);
-				parsed = true;
-			}
+		} else if(line_in.matchStaticString("-A")){
+			parseRule(state,line_in,line);
+			parsed = true;
 		}
 		if(!parsed){
 			mlog::log("ignoring \"{}\"\n",line);
 		}
 	}
-	finishChains();
+	finishChains(state);
 }
-void RulesetParser::finishChains(){
-	if(tables.empty())return;
-	for (auto& [chain_name, chain]  : chains) {
+void RulesetParser::finishChains(table_state_t& state){
+	for (auto& [chain_name, chain]  : state.chains) {
 		if(chain_name == "ACCEPT")chain->special = Chain::Special::ACCEPT;
 		else if(chain_name == "DROP")chain->special = Chain::Special::DROP;
 		else if(chain_name == "REJECT")chain->special = Chain::Special::REJECT;
 		else if(chain_name == "RETURN")chain->special = Chain::Special::RETURN;
 		else if(chain_name == "DNAT")chain->special = Chain::Special::DNAT;
 		else if(chain_name == "SNAT")chain->special = Chain::Special::SNAT;
-		curTable().chains.emplace_back(std::move(chain));
+		state.table.chains.emplace_back(std::move(chain));
 	}
-	chains.clear();
+	state.chains.clear();
 }
 void RulesetParser::parseRuleset_NFT(std::string_view filename){
 	std::ifstream file(filename.data());
@@ -487,8 +446,10 @@ void RulesetParser::parseRuleset_NFT(std::istream& in){
 				}
 			}
 			if(!ret.jumpTarget)ret.shouldBeIgnored = true;
+			//table_name and chain_name point into line, so the chain is looked up before line is moved
+			auto& chain = getChainOrCreate_NFT(table_name,chain_name);
 			ret.line_str = std::move(line);
-			getChainOrCreate_NFT(table_name,chain_name).rules.emplace_back(std::move(ret));
+			chain.rules.emplace_back(std::move(ret));
 		}else{
 			mlog::warn("unknown word \"{}\" in line {}",add_type,this->line);
 		}
@@ -507,21 +468,53 @@ void RulesetParser::parseRuleset_NFT(std::istream& in){
 	ruleset.tables = std::move(tables);
 }
 void RulesetParser::parseRuleset(std::istream& in){
-	std::string line;
-	std::getline(in,line);
-	while(!in.eof() && in.good()){
-		std::stringstream line_in(line);
+	std::string text{std::istreambuf_iterator<char>(in),std::istreambuf_iterator<char>()};
+	parseRulesetBuffer(text);
+}
+void RulesetParser::parseRulesetBuffer(std::string_view text){
+	//the tables are split at their "*table" and "COMMIT" lines and parsed concurrently
+	std::vector<table_state_t> states;
+	try_parser lines(text);
+	while(!lines.done()){
+		auto line = lines.line();
 		this->line++;
-		char c;
-		line_in >> c;
-		if (c=='*'){//anouncing table
-			std::string table_name;
-			line_in >> table_name;
-			parseTable(in,std::move(table_name));
-		}else{
+		try_parser line_in(line);
+		line_in.ws();
+		if(!line_in.matchStaticString("*")){
 			mlog::debug("[parser_error] ignoring \"{}\"\n",line);
+			continue;
 		}
-		std::getline(in,line);
+		auto& state = states.emplace_back();
+		state.table.name = line_in.string();
+		state.line = this->line;
+		auto begin = lines.position();
+		auto end = begin;
+		while(!lines.done()){
+			auto table_line = lines.line();
+			this->line++;
+			if(table_line == "COMMIT")break;
+			end = lines.position();
+		}
+		state.text = text.substr(begin,end-begin);
+	}
+
+	std::exception_ptr error;
+#pragma omp parallel for schedule(dynamic,1) num_threads(args::regionThreads())
+	for(size_t i = 0; i < states.size(); ++i){
+		try{
+			parseTable(states[i],states[i].text);
+		}catch(...){
+#pragma omp critical
+			error = std::current_exception();
+		}
+	}
+	if(error)std::rethrow_exception(error);
+
+	for(auto& state : states){
+		results.unknownFlags.merge(state.results.unknownFlags);
+		results.rulesWithoutJumpTarget.insert(std::end(results.rulesWithoutJumpTarget),
+				std::begin(state.results.rulesWithoutJumpTarget),std::end(state.results.rulesWithoutJumpTarget));
+		tables.emplace_back(std::move(state.table));
 	}
 	mlog::debug("parsed {} tables\n",tables.size());
 	int sum_rules = 0;
@@ -535,6 +528,14 @@ void RulesetParser::parseRuleset(std::istream& in){
 	mlog::debug("parsed {} chains\n",sum_chains);
 	mlog::debug("parsed {} rules\n",sum_rules);
 	ruleset.tables = std::move(tables);
+	//the names only stay at their address once the tables are in place
+	for(auto& table : ruleset.tables){
+		for(auto& chain : table.chains){
+			for(auto& rule : chain->rules){
+				rule.table_name = table.name;
+			}
+		}
+	}
 }
 void RulesetParser::parseIpSets(std::string_view filename){
 	std::ifstream file(filename.data());
@@ -587,12 +588,19 @@ void RulesetParser::parseIpSets(std::istream& file){
 }
 
 void RulesetParser::parseRuleset(std::string_view filename){
-	std::ifstream file(filename.data());
-	if(!file.good()){
-		mlog::fatal("could not open \"{}\"\n",filename);
+	util::mapped_file file{std::string{filename}};
+	if(file.good()){
+		mlog::log("parsing ruleset file \"{}\"\n",filename);
+		parseRulesetBuffer(file.view());
+	}else{
+		//pipes like <(iptables-save) can't be mapped and are read instead
+		std::ifstream in(std::string{filename});
+		if(!in.good()){
+			mlog::fatal("could not open \"{}\"\n",filename);
+		}
+		mlog::log("parsing ruleset file \"{}\"\n",filename);
+		parseRuleset(in);
 	}
-	mlog::log("parsing ruleset file \"{}\"\n",filename);
-	parseRuleset(file);
 	mlog::success("done parsing ruleset file \"{}\"\n",filename);
 }
 
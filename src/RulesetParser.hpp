@@ -4,11 +4,13 @@
 #include <set>
 #include <string>
 #include <vector>
+#include <mutex>
 #include "parser/IpSet.hpp"
 #include "Ruleset.hpp"
 #include "SegmentSet.hpp"
 #include "config.hpp"
 #include "util.hpp"
+#include "try_parser.hpp"
 
 
 struct parse_result_t {
@@ -19,8 +21,15 @@ struct parse_result_t {
 struct RulesetParser {
 public:
 
+	//!maps the file into memory and parses it with parseRulesetBuffer, files that can't be mapped, like pipes, are read
 	void parseRuleset(std::string_view filename);
 	void parseRuleset(std::istream& in);
+	/**
+	 * parses an iptables-save dump without copying it line by line\n
+	 * the tables are parsed concurrently by up to args::threads threads\n
+	 * text only has to live during the call, the rules keep copies of their lines
+	 */
+	void parseRulesetBuffer(std::string_view text);
 	void parseRuleset_NFT(std::string_view filename);
 	void parseRuleset_NFT(std::istream& in);
 
@@ -32,21 +41,36 @@ public:
 
 
 private:
-	
+	//!everything a single table of an iptables-save dump is parsed into
+	struct table_state_t {
+		Table table;
+		std::unordered_map<std::string,std::unique_ptr<Chain>,util::string_hash,std::equal_to<>> chains;
+		parse_result_t results;
+		std::string_view text;///<lines between "*table" and "COMMIT"
+		int line = 0;///<line of the dump that was parsed last
+	};
 
 	Table& curTable();
-	Chain& getChainOrCreate(const std::string& name);
+	Chain& getChainOrCreate(table_state_t& state, std::string_view name);
+	/**
+	 * the indices of interfaces and protocols are shared by all tables\n
+	 * which index a name gets depends on the order the threads reach it,\n
+	 * the analyses only compare them for equality
+	 */
+	auto index(util::indexer<std::string,uint8_t>& indexer, std::string_view name) -> uint8_t;
 	Chain& getChainOrCreate_NFT(const std::string_view table_name, const std::string_view chain_name);
 
-	void parseRule(std::istream& in, std::string line_str);
-	void parseTable(std::istream& in, std::string&& table_name);
+	//!parses the rest of line_str after "-A" from in
+	void parseRule(table_state_t& state, try_parser& in, std::string_view line_str);
+	//!parses the chain declarations and rules of text into state
+	void parseTable(table_state_t& state, std::string_view text);
 
 	void parseRule_NFT(std::istream& in, std::string line_str);
 	void parseTable_NFT(std::istream& in);
-	void finishChains();
+	//!moves the chains of state into its table
+	void finishChains(table_state_t& state);
 
 public:
-	std::unordered_map<std::string,std::unique_ptr<Chain>> chains;
 	std::unordered_map<std::string,std::unordered_map<std::string,std::unique_ptr<Chain>>> nft_chains;
 	util::indexer<std::string,uint8_t> in_interfaces;
 	util::indexer<std::string,uint8_t> out_interfaces;
@@ -58,4 +82,6 @@ public:
 	parse_result_t results;
 	std::vector<Table> tables;
 	int line = 0;
+private:
+	std::mutex index_mutex;
 };
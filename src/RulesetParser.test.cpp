@@ -1,6 +1,14 @@
 #include <gtest/gtest.h>
 #include <sstream>
+#include <algorithm>
+#include <map>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <sys/stat.h>
 #include "RulesetParser.hpp"
+#include "args.hpp"
+#include <fmt/format.h>
 
 TEST(ruleset_parser,nft){
 	auto ruleset_text = 
@@ -17,3 +25,136 @@ TEST(ruleset_parser,nft){
 	ASSERT_EQ(1,ruleset.tables[0].chains.size());
 	ASSERT_EQ(1,ruleset.tables[0].chains[0]->rules.size());
 }
+TEST(ruleset_parser,iptables_buffer){
+	//the last line has no trailing newline
+	std::string ruleset_text = 
+		"# Generated by iptables-save\n"
+		"*nat\n"
+		":PREROUTING ACCEPT [0:0]\n"
+		"-A PREROUTING ! -s 10.0.0.0/8 -p tcp -m tcp --dport 80:81 -j DNAT --to-destination 1.2.3.4-1.2.3.5:8080-8081\n"
+		"-A PREROUTING -i eth0 -m comment --comment \"quoted comment\" -j DNAT --to-destination 1.2.3.4\n"
+		"COMMIT\n"
+		"*filter\n"
+		":INPUT DROP [0:0]\n"
+		"-A INPUT -s 10.0.0.0/8 -j ACCEPT\n"
+		"COMMIT";
+	RulesetParser parser;
+	parser.parseRulesetBuffer(ruleset_text);
+	ruleset_text.assign(ruleset_text.size(),'x');
+
+	auto ruleset = parser.releaseRuleset();
+
+	ASSERT_EQ(2,ruleset.tables.size());
+	EXPECT_EQ("nat",ruleset.tables[0].name);
+	EXPECT_EQ("filter",ruleset.tables[1].name);
+	//jump targets like DNAT are chains as well
+	auto findChain = [&](size_t table, std::string_view name) -> const Chain& {
+		auto& chains = ruleset.tables[table].chains;
+		return **std::ranges::find_if(chains,[&](const auto& chain){return chain->name == name;});
+	};
+	const auto& rules = findChain(0,"PREROUTING").rules;
+	ASSERT_EQ(2,rules.size());
+	EXPECT_EQ(4,rules[0].line);
+	EXPECT_EQ(0,rules[0].line_str.find("-A PREROUTING ! -s"));
+	EXPECT_EQ((Rule::NAT_Transform{0x01020304,0x01020305,true,8080,8081}),rules[0].nat);
+	EXPECT_EQ((Rule::NAT_Transform{0x01020304,0x01020304,false,0,0}),rules[1].nat);
+
+	PSegment seg;
+	seg.setInterval<PSegment::SRC_IP_INDEX>(0x0A000000,0x0AFFFFFF);
+	EXPECT_FALSE(rules[0].maximumMatchingSet.intersects(PSET{{seg}}));
+	const auto& input = findChain(1,"INPUT").rules;
+	ASSERT_EQ(1,input.size());
+	EXPECT_TRUE(input[0].maximumMatchingSet.isSubsetOf(PSET{{seg}}));
+	EXPECT_EQ(9,input[0].line);
+}
+TEST(ruleset_parser,iptables_pipe){
+	//pipes like <(iptables-save) report no size and can't be mapped
+	auto path = (std::filesystem::temp_directory_path()/"fw-analyzer-parser.fifo").string();
+	std::filesystem::remove(path);
+	ASSERT_EQ(mkfifo(path.c_str(),0600),0);
+	std::thread writer([&path](){
+		std::ofstream(path) << "*filter\n:INPUT DROP [0:0]\n-A INPUT -s 10.0.0.0/8 -j ACCEPT\n-A INPUT -j DROP\nCOMMIT\n";
+	});
+	RulesetParser parser;
+	parser.parseRuleset(std::string_view{path});
+	writer.join();
+	std::filesystem::remove(path);
+
+	auto ruleset = parser.releaseRuleset();
+	ASSERT_EQ(ruleset.tables.size(),1);
+	ASSERT_NE(ruleset.findChain("filter","INPUT"),nullptr);
+	EXPECT_EQ(ruleset.findChain("filter","INPUT")->rules.size(),2);
+}
+TEST(ruleset_parser,concurrent_tables){
+	std::string ruleset_text;
+	for(int table = 0; table < 8; ++table){
+		ruleset_text += fmt::format("*table{}\n:INPUT ACCEPT [0:0]\n:chain - [0:0]\n",table);
+		for(int rule = 0; rule < 50; ++rule){
+			ruleset_text += fmt::format("-A {} -s 10.0.{}.{} -i eth{} -j {}\n",rule%2 ? "INPUT" : "chain",table,rule,rule%5,rule%3 ? "DROP" : "chain");
+		}
+		ruleset_text += "COMMIT\n# comment between tables\n";
+	}
+	auto parse = [&](int threads){
+		args::threads = threads;
+		RulesetParser parser;
+		parser.parseRulesetBuffer(ruleset_text);
+		args::threads = 1;
+		return parser.releaseRuleset();
+	};
+	auto serial = parse(1);
+	auto concurrent = parse(4);
+	ASSERT_EQ(8,concurrent.tables.size());
+	std::map<int,uint32_t> interfaces;
+	for(size_t table = 0; table < 8; ++table){
+		ASSERT_EQ(serial.tables[table].name,concurrent.tables[table].name);
+		ASSERT_EQ(serial.tables[table].chains.size(),concurrent.tables[table].chains.size());
+		for(size_t chain = 0; chain < serial.tables[table].chains.size(); ++chain){
+			const auto& expected = *serial.tables[table].chains[chain];
+			const auto& actual = *concurrent.tables[table].findChain(expected.name);
+			ASSERT_EQ(expected.rules.size(),actual.rules.size());
+			for(size_t rule = 0; rule < expected.rules.size(); ++rule){
+				const auto& r = actual.rules[rule];
+				EXPECT_EQ(expected.rules[rule].line,r.line);
+				EXPECT_EQ(expected.rules[rule].line_str,r.line_str);
+				EXPECT_EQ(concurrent.tables[table].name,r.table_name);
+				EXPECT_EQ(expected.rules[rule].flag_segments[Rule::SRC_IP],r.flag_segments[Rule::SRC_IP]);
+				//the interfaces may be numbered differently, but equal names share an index in all tables
+				auto in_interface = r.flag_segments[Rule::IN_INTERFACE].begin()->first;
+				auto eth = r.line_str[r.line_str.find("eth")+3]-'0';
+				EXPECT_EQ(interfaces.emplace(eth,in_interface).first->second,in_interface);
+			}
+		}
+	}
+	EXPECT_EQ(5,interfaces.size());
+}
+TEST(ruleset_parser,ip_set_shared_between_rules){
+	std::stringstream ip_set_input(
+		"create abc hash:net,port\n"
+		"add abc 1.2.3.0/24,udp:53\n"
+		"add abc 4.3.2.1,tcp:80\n");
+	RulesetParser parser;
+	parser.parseIpSets(ip_set_input);
+	auto* set = parser.ip_sets.get("abc");
+	auto src = set->toPSET("src,dst");
+	EXPECT_EQ(src,set->toPSET("src,dst"));
+	EXPECT_NE(src,set->toPSET("dst,dst"));
+	EXPECT_EQ(2,src->segments.size());
+
+	parser.parseRulesetBuffer(
+		"*filter\n"
+		"-A INPUT -m set --match-set abc src,dst -j ACCEPT\n"
+		"-A INPUT -s 1.2.3.4 -m set --match-set abc src,dst -j ACCEPT\n"
+		"-A INPUT -m set --match-set abc src,dst -j DROP\n"
+		"COMMIT\n");
+	auto ruleset = parser.releaseRuleset();
+	const auto& rules = ruleset.tables[0].findChain("INPUT")->rules;
+	ASSERT_EQ(3,rules.size());
+	EXPECT_EQ(*src,rules[0].maximumMatchingSet);
+	EXPECT_EQ(*src,rules[2].maximumMatchingSet);
+	EXPECT_EQ(rules[0].flag_segments,rules[2].flag_segments);
+	PSegment host;
+	host.setInterval<PSegment::SRC_IP_INDEX>(0x01020304,0x01020304);
+	EXPECT_TRUE(rules[1].maximumMatchingSet.isSubsetOf(PSET{{host}}));
+	EXPECT_TRUE(rules[1].maximumMatchingSet.isSubsetOf(*src));
+	EXPECT_FALSE(rules[1].maximumMatchingSet.isEmpty());
+}
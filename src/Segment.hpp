@@ -165,6 +165,15 @@ public:
 		return {false,false};
 	}
 
+	/**
+	 * @return true if both segments have at least one point in common\n
+	 * equivalent to !intersect(*this,other).empty() without constructing the intersection
+	 */
+	constexpr bool overlaps(const self_t& other) const{
+		return start_m <= other.end_m && other.start_m <= end_m
+			&& start_m <= end_m && other.start_m <= other.end_m
+			&& parent_t::overlaps(other);
+	}
 	/**
 	 * the resulting segment will contain all points
 	 * that were contained in both segments
@@ -178,6 +187,14 @@ public:
 	bool operator==(const self_t& other) const{
 		return start_m == other.start_m && end_m == other.end_m && parent_t::operator==(other);
 	}
+	/**
+	 * lexicographic order over (start,end) of each dimension beginning with the first
+	 */
+	bool operator<(const self_t& other) const{
+		if(start_m != other.start_m)return start_m < other.start_m;
+		if(end_m != other.end_m)return end_m < other.end_m;
+		return parent_t::operator<(other);
+	}
 	/* bool operator!=(const self_t& other) const{ */
 	/* 	return !(*this == other); */
 	/* } */
@@ -210,6 +227,9 @@ class Segment<void> {
 	using dimension_t = void;
 	constexpr static int dimensions = 0;
 	void intersect(__attribute__((unused)) const self_t& other) {}
+	constexpr bool overlaps(__attribute__((unused)) const self_t& other) const{
+		return true;
+	}
 	constexpr bool empty() const{
 		return false;
 	}
@@ -219,6 +239,9 @@ class Segment<void> {
 	bool operator!=(__attribute__((unused)) const self_t& other) const{
 		return false;
 	}
+	bool operator<(__attribute__((unused)) const self_t& other) const{
+		return false;
+	}
 	auto getAmountPoints() const -> long double {
 		return 1;
 	}
@@ -0,0 +1,112 @@
+#include "SegmentColumns.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace simd {
+
+	//box has to be checked once, the kernels only test the columns
+	static bool emptyBox(size_t dims, const int32_t* box){
+		for(size_t d = 0; d < dims; ++d){
+			if(box[2*d] > box[2*d+1])return true;
+		}
+		return false;
+	}
+
+	size_t nextOverlap_scalar(const int32_t* columns, size_t stride, size_t dims, size_t size, const int32_t* box, size_t from){
+		if(emptyBox(dims,box))return size;
+		const int32_t* empty = columns+(2*dims)*stride;
+		for(size_t i = from; i < size; ++i){
+			bool overlap = empty[i] == 0;
+			for(size_t d = 0; d < dims && overlap; ++d){
+				overlap = columns[(2*d)*stride+i] <= box[2*d+1] && box[2*d] <= columns[(2*d+1)*stride+i];
+			}
+			if(overlap)return i;
+		}
+		return size;
+	}
+
+#ifdef SIMD_X86
+	//every lane of reject is set for segments that can't overlap with box
+	__attribute__((target("sse4.1")))
+	size_t nextOverlap_sse4(const int32_t* columns, size_t stride, size_t dims, size_t size, const int32_t* box, size_t from){
+		if(emptyBox(dims,box))return size;
+		const int32_t* empty = columns+(2*dims)*stride;
+		const __m128i all = _mm_set1_epi32(-1);
+		size_t i = from;
+		for(; i+4 <= size; i += 4){
+			__m128i reject = _mm_loadu_si128((const __m128i*)(empty+i));
+			for(size_t d = 0; d < dims && !_mm_testc_si128(reject,all); ++d){
+				auto start = _mm_loadu_si128((const __m128i*)(columns+(2*d)*stride+i));
+				auto end = _mm_loadu_si128((const __m128i*)(columns+(2*d+1)*stride+i));
+				reject = _mm_or_si128(reject,_mm_cmpgt_epi32(start,_mm_set1_epi32(box[2*d+1])));
+				reject = _mm_or_si128(reject,_mm_cmpgt_epi32(_mm_set1_epi32(box[2*d]),end));
+			}
+			int mask = ~_mm_movemask_ps(_mm_castsi128_ps(reject)) & 0xF;
+			if(mask != 0)return i+__builtin_ctz(mask);
+		}
+		return nextOverlap_scalar(columns,stride,dims,size,box,i);
+	}
+
+	__attribute__((target("avx2")))
+	size_t nextOverlap_avx2(const int32_t* columns, size_t stride, size_t dims, size_t size, const int32_t* box, size_t from){
+		if(emptyBox(dims,box))return size;
+		const int32_t* empty = columns+(2*dims)*stride;
+		const __m256i all = _mm256_set1_epi32(-1);
+		size_t i = from;
+		for(; i+8 <= size; i += 8){
+			__m256i reject = _mm256_loadu_si256((const __m256i*)(empty+i));
+			for(size_t d = 0; d < dims && !_mm256_testc_si256(reject,all); ++d){
+				auto start = _mm256_loadu_si256((const __m256i*)(columns+(2*d)*stride+i));
+				auto end = _mm256_loadu_si256((const __m256i*)(columns+(2*d+1)*stride+i));
+				reject = _mm256_or_si256(reject,_mm256_cmpgt_epi32(start,_mm256_set1_epi32(box[2*d+1])));
+				reject = _mm256_or_si256(reject,_mm256_cmpgt_epi32(_mm256_set1_epi32(box[2*d]),end));
+			}
+			int mask = ~_mm256_movemask_ps(_mm256_castsi256_ps(reject)) & 0xFF;
+			if(mask != 0)return i+__builtin_ctz(mask);
+		}
+		return nextOverlap_sse4(columns,stride,dims,size,box,i);
+	}
+
+	bool supported(level l){
+		switch(l){
+			case level::scalar: return true;
+			case level::sse4: return __builtin_cpu_supports("sse4.1");
+			case level::avx2: return __builtin_cpu_supports("avx2");
+		}
+		return false;
+	}
+#else
+	size_t nextOverlap_sse4(const int32_t* columns, size_t stride, size_t dims, size_t size, const int32_t* box, size_t from){
+		return nextOverlap_scalar(columns,stride,dims,size,box,from);
+	}
+	size_t nextOverlap_avx2(const int32_t* columns, size_t stride, size_t dims, size_t size, const int32_t* box, size_t from){
+		return nextOverlap_scalar(columns,stride,dims,size,box,from);
+	}
+	bool supported(level l){
+		return l == level::scalar;
+	}
+#endif
+
+	level best(){
+		if(supported(level::avx2))return level::avx2;
+		if(supported(level::sse4))return level::sse4;
+		return level::scalar;
+	}
+
+	size_t nextOverlap(level l, const int32_t* columns, size_t stride, size_t dims, size_t size, const int32_t* box, size_t from){
+		switch(l){
+			case level::avx2: return nextOverlap_avx2(columns,stride,dims,size,box,from);
+			case level::sse4: return nextOverlap_sse4(columns,stride,dims,size,box,from);
+			case level::scalar: return nextOverlap_scalar(columns,stride,dims,size,box,from);
+		}
+		return nextOverlap_scalar(columns,stride,dims,size,box,from);
+	}
+
+	size_t nextOverlap(const int32_t* columns, size_t stride, size_t dims, size_t size, const int32_t* box, size_t from){
+		static const level selected = best();
+		return nextOverlap(selected,columns,stride,dims,size,box,from);
+	}
+}
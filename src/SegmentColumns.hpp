@@ -0,0 +1,124 @@
+#pragma once
+#include "vector.hpp"
+#include "util.hpp"
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <type_traits>
+
+/**
+ * @brief overlap kernels working on segments stored as columns
+ * @details columns[(2*d)*stride+i] is the start and columns[(2*d+1)*stride+i] the end\n
+ * of the d'th dimension of the i'th segment\n
+ * columns[(2*dims)*stride+i] is -1 if the i'th segment is empty and 0 otherwise\n
+ * all values are stored with flipped sign bit so that signed comparisons\n
+ * order them like the original unsigned values\n
+ * box holds the start and end of each dimension interleaved (box[2*d],box[2*d+1])\n
+ * in the same representation\n
+ * every kernel returns the index of the first segment in [from,size)\n
+ * whose intersection with box is not empty or size if there is none\n
+ * the sse4 and avx2 variants test 4 and 8 segments per instruction\n
+ * and may only be called if supported(level) is true
+ */
+namespace simd {
+	enum class level {
+		scalar,
+		sse4,
+		avx2
+	};
+	/**
+	 * @return whether the current cpu can execute the kernels of this level
+	 */
+	bool supported(level);
+	/**
+	 * @return the best level supported by the current cpu
+	 */
+	level best();
+	constexpr int32_t toColumn(uint32_t value){
+		return static_cast<int32_t>(value ^ 0x80000000u);
+	}
+	auto nextOverlap(const int32_t* columns, size_t stride, size_t dims, size_t size, const int32_t* box, size_t from) -> size_t;
+	auto nextOverlap(level, const int32_t* columns, size_t stride, size_t dims, size_t size, const int32_t* box, size_t from) -> size_t;
+	auto nextOverlap_scalar(const int32_t* columns, size_t stride, size_t dims, size_t size, const int32_t* box, size_t from) -> size_t;
+	auto nextOverlap_sse4(const int32_t* columns, size_t stride, size_t dims, size_t size, const int32_t* box, size_t from) -> size_t;
+	auto nextOverlap_avx2(const int32_t* columns, size_t stride, size_t dims, size_t size, const int32_t* box, size_t from) -> size_t;
+}
+
+/**
+ * @brief structure of arrays copy of a collection of segments
+ * @details every dimension is stored as one contiguous array of starts\n
+ * and one contiguous array of ends widened to 32 bit\n
+ * so that overlap tests can check several segments per instruction\n
+ * the kernel is selected at runtime by the capabilities of the cpu\n
+ * like SegmentIndex the copy has to be rebuilt after the original collection changes\n
+ * in the following complexity descriptions:
+ * - @b n denotes the amount of stored segments
+ * - @b d denotes the dimensionality of the segment type
+ */
+template<typename segment_t>
+class SegmentColumns {
+public:
+	constexpr static size_t dimensions = segment_t::dimensions;
+
+	SegmentColumns() = default;
+	/**
+	 * runtime O(n*d)
+	 */
+	SegmentColumns(const bor::vector<segment_t>& segments)
+		: size_m(segments.size()),
+		  stride((segments.size()+7)/8*8),
+		  columns((2*dimensions+1)*stride)
+	{
+		for(size_t i = 0; i < size_m; ++i){
+			util::constexpr_for<0,dimensions,1>([&](auto dim){
+						using dimension_t = std::remove_cvref_t<decltype(segments[i].template getStart<dim>())>;
+						static_assert(std::is_unsigned_v<dimension_t> && sizeof(dimension_t) <= sizeof(uint32_t),
+								"SegmentColumns stores dimensions as uint32_t");
+						columns[(2*dim)*stride+i] = simd::toColumn(segments[i].template getStart<dim>());
+						columns[(2*dim+1)*stride+i] = simd::toColumn(segments[i].template getEnd<dim>());
+					});
+			columns[(2*dimensions)*stride+i] = segments[i].empty() ? -1 : 0;
+		}
+	}
+
+	/**
+	 * @return the index of the first segment at or after @b from overlapping with box\n
+	 * or size() if there is none\n
+	 * runtime O(n*d)
+	 */
+	auto nextOverlap(const segment_t& box, size_t from = 0) const -> size_t {
+		auto box_columns = toBox(box);
+		return simd::nextOverlap(columns.data(),stride,dimensions,size_m,box_columns.data(),from);
+	}
+	/**
+	 * same as nextOverlap(box,from) but uses the kernel of the given level
+	 */
+	auto nextOverlap(const segment_t& box, size_t from, simd::level level) const -> size_t {
+		auto box_columns = toBox(box);
+		return simd::nextOverlap(level,columns.data(),stride,dimensions,size_m,box_columns.data(),from);
+	}
+	/**
+	 * @return whether any stored segment overlaps with box
+	 */
+	bool overlaps(const segment_t& box) const {
+		return nextOverlap(box) != size_m;
+	}
+
+	size_t size() const {
+		return size_m;
+	}
+
+private:
+	static auto toBox(const segment_t& box) -> std::array<int32_t,2*dimensions> {
+		std::array<int32_t,2*dimensions> ret;
+		util::constexpr_for<0,dimensions,1>([&](auto dim){
+					ret[2*dim] = simd::toColumn(box.template getStart<dim>());
+					ret[2*dim+1] = simd::toColumn(box.template getEnd<dim>());
+				});
+		return ret;
+	}
+
+	size_t size_m = 0;
+	size_t stride = 0;///< length of one column, padded to a multiple of 8
+	std::vector<int32_t> columns;
+};
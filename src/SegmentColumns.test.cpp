@@ -0,0 +1,42 @@
+#include <gtest/gtest.h>
+#include <rapidcheck/gtest.h>
+#include "SegmentColumns.hpp"
+#include "SegmentSet.hpp"
+#include "SegmentSet-generator.hpp"
+
+TEST(SegmentColumns,single_dimension){
+	bor::vector<PSegment> segments;
+	for(uint32_t i = 0; i < 100; ++i){
+		segments.push_back(PSegment(i*10,i*10+5));
+	}
+	SegmentColumns<PSegment> columns(segments);
+	EXPECT_EQ(columns.size(),100);
+	EXPECT_EQ(columns.nextOverlap(PSegment(23,41)),2);
+	EXPECT_EQ(columns.nextOverlap(PSegment(23,41),3),3);
+	EXPECT_EQ(columns.nextOverlap(PSegment(23,41),5),100);
+	EXPECT_FALSE(columns.overlaps(PSegment(6,9)));
+}
+RC_GTEST_PROP(SegmentColumns,kernels_equal_intersect,(const std::vector<PSegment>& segments, const PSegment& box)){
+	bor::vector<PSegment> vec(segments);
+	SegmentColumns<PSegment> columns(vec);
+	std::vector<size_t> expected;
+	for(size_t i = 0; i < segments.size(); ++i){
+		if(!intersect(segments[i],box).empty())expected.push_back(i);
+	}
+	std::vector<size_t> found;
+	for(size_t i = columns.nextOverlap(box); i < columns.size(); i = columns.nextOverlap(box,i+1)){
+		found.push_back(i);
+	}
+	RC_ASSERT(found == expected);
+
+	//every kernel the cpu supports has to agree with the scalar one
+	for(size_t from = 0; from <= columns.size(); ++from){
+		auto scalar = columns.nextOverlap(box,from,simd::level::scalar);
+		if(simd::supported(simd::level::sse4)){
+			RC_ASSERT(columns.nextOverlap(box,from,simd::level::sse4) == scalar);
+		}
+		if(simd::supported(simd::level::avx2)){
+			RC_ASSERT(columns.nextOverlap(box,from,simd::level::avx2) == scalar);
+		}
+	}
+}
@@ -0,0 +1,171 @@
+#pragma once
+#include "vector.hpp"
+#include "util.hpp"
+#include <vector>
+#include <array>
+#include <limits>
+#include <algorithm>
+#include <cstdint>
+
+/**
+ * @brief bulk loaded bounding volume hierarchy over a collection of segments
+ * @details answers "which segments overlap this box" without looking at every segment\n
+ * the tree is built once over a copy of the segments and has to be rebuilt\n
+ * after the original collection has been modified, which indexes() detects\n
+ * every node stores the bounding segment of all segments below it\n
+ * nodes are split on the dimension with the largest relative extent\n
+ * in the following complexity descriptions:
+ * - @b n denotes the amount of indexed segments
+ * - @b k denotes the amount of segments reported by a query
+ */
+template<typename segment_t>
+class SegmentIndex {
+public:
+	constexpr static size_t leaf_size = 8;
+
+	SegmentIndex() = default;
+	SegmentIndex(const bor::vector<segment_t>& segments){
+		build(segments);
+	}
+
+	/**
+	 * replaces the indexed segments\n
+	 * runtime O(n*log(n))
+	 */
+	void build(const bor::vector<segment_t>& segments){
+		source_m = segments;
+		segments_m.clear();
+		ids.clear();
+		nodes.clear();
+		if(segments.empty())return;
+		std::vector<uint32_t> order(segments.size());
+		for(size_t i = 0; i < order.size(); ++i)order[i] = i;
+		nodes.reserve(2*(segments.size()/leaf_size+1));
+		build(segments,order,0,order.size());
+
+		segments_m.reserve(order.size());
+		ids.reserve(order.size());
+		for(auto id : order){
+			segments_m.push_back(segments[id]);
+			ids.push_back(id);
+		}
+	}
+
+	/**
+	 * calls cb(segment,id) for every indexed segment overlapping with box\n
+	 * id is the position of the segment in the collection the index was built from\n
+	 * the search stops as soon as cb returns false\n
+	 * runtime O(log(n)+k) for small boxes
+	 * @return false if the search was stopped by cb
+	 */
+	template<typename F>
+	bool query(const segment_t& box, F&& cb) const {
+		if(nodes.empty())return true;
+		std::array<uint32_t,64> stack;
+		size_t top = 0;
+		stack[top++] = 0;
+		while(top != 0){
+			const auto& node = nodes[stack[--top]];
+			if(!node.bounds.overlaps(box))continue;
+			if(node.left == 0){
+				for(size_t i = node.begin; i < node.end; ++i){
+					if(!segments_m[i].overlaps(box))continue;
+					if(!cb(segments_m[i],static_cast<size_t>(ids[i])))return false;
+				}
+			}else{
+				stack[top++] = node.left;
+				stack[top++] = node.right;
+			}
+		}
+		return true;
+	}
+	/**
+	 * @return whether any indexed segment overlaps with box
+	 */
+	bool overlaps(const segment_t& box) const {
+		return !query(box,[](const segment_t&, size_t){ return false; });
+	}
+
+	size_t size() const {
+		return segments_m.size();
+	}
+	/**
+	 * @returns whether segments is the unmodified collection the index was built from\n
+	 * the index shares its storage, every modification of segments copies them into own storage first
+	 */
+	bool indexes(const bor::vector<segment_t>& segments) const {
+		return segments.size() == source_m.size() && segments.data() == source_m.data();
+	}
+	bool empty() const {
+		return segments_m.empty();
+	}
+
+private:
+	struct node_t {
+		segment_t bounds;
+		uint32_t begin, end;///< range in segments_m covered by this node
+		uint32_t left = 0, right = 0;///< children, left == 0 marks a leaf
+	};
+
+	static segment_t boundingSegment(const bor::vector<segment_t>& segments, const std::vector<uint32_t>& order, size_t begin, size_t end){
+		segment_t ret = segments[order[begin]];
+		for(size_t i = begin+1; i < end; ++i){
+			const auto& seg = segments[order[i]];
+			util::constexpr_for<0,segment_t::dimensions,1>([&](auto dim){
+						auto& start = ret.template getStart<dim>();
+						auto& s_end = ret.template getEnd<dim>();
+						start = std::min(start,seg.template getStart<dim>());
+						s_end = std::max(s_end,seg.template getEnd<dim>());
+					});
+		}
+		return ret;
+	}
+	//!@returns the dimension in which bounds has the largest extent relative to the range of its type
+	static int widestDimension(const segment_t& bounds){
+		int ret = 0;
+		long double widest = -1;
+		util::constexpr_for<0,segment_t::dimensions,1>([&](auto dim){
+					using dimension_t = std::remove_cvref_t<decltype(bounds.template getStart<dim>())>;
+					long double extent = bounds.template getEnd<dim>() - (long double)bounds.template getStart<dim>();
+					extent /= (long double)std::numeric_limits<dimension_t>::max() - std::numeric_limits<dimension_t>::min();
+					if(extent > widest){
+						widest = extent;
+						ret = dim;
+					}
+				});
+		return ret;
+	}
+	uint32_t build(const bor::vector<segment_t>& segments, std::vector<uint32_t>& order, size_t begin, size_t end){
+		uint32_t node_id = nodes.size();
+		nodes.push_back({boundingSegment(segments,order,begin,end),(uint32_t)begin,(uint32_t)end});
+		if(end-begin <= leaf_size)return node_id;
+
+		auto split_dim = widestDimension(nodes[node_id].bounds);
+		auto mid = begin+(end-begin)/2;
+		util::constexpr_for<0,segment_t::dimensions,1>([&](auto dim){
+					constexpr int d = decltype(dim)::value;
+					if(d != split_dim)return;
+					auto center = [&segments](uint32_t id){
+						const auto& seg = segments[id];
+						return seg.template getStart<d>()/2.0L + seg.template getEnd<d>()/2.0L;
+					};
+					std::nth_element(
+							order.begin()+begin,
+							order.begin()+mid,
+							order.begin()+end,
+							[&center](uint32_t id1, uint32_t id2){
+								return center(id1) < center(id2);
+							});
+				});
+		auto left = build(segments,order,begin,mid);
+		auto right = build(segments,order,mid,end);
+		nodes[node_id].left = left;
+		nodes[node_id].right = right;
+		return node_id;
+	}
+
+	bor::vector<segment_t> source_m;///< shares the storage of the collection the index was built from
+	bor::vector<segment_t> segments_m;///< indexed segments ordered by leaf
+	std::vector<uint32_t> ids;///< position of segments_m[i] in the collection the index was built from
+	std::vector<node_t> nodes;///< nodes[0] is the root
+};
@@ -0,0 +1,55 @@
+#include <gtest/gtest.h>
+#include <rapidcheck/gtest.h>
+#include "SegmentIndex.hpp"
+#include "SegmentSet.hpp"
+#include "SegmentSet-generator.hpp"
+
+TEST(SegmentIndex,empty){
+	SegmentIndex<PSegment> index;
+	EXPECT_TRUE(index.empty());
+	EXPECT_FALSE(index.overlaps(PSegment{}));
+}
+TEST(SegmentIndex,single_dimension){
+	bor::vector<PSegment> segments;
+	for(uint32_t i = 0; i < 100; ++i){
+		segments.push_back(PSegment(i*10,i*10+5));
+	}
+	SegmentIndex<PSegment> index(segments);
+	EXPECT_EQ(index.size(),100);
+	std::vector<size_t> found;
+	index.query(PSegment(23,41),[&](const PSegment&, size_t id){
+				found.push_back(id);
+				return true;
+			});
+	std::sort(found.begin(),found.end());
+	EXPECT_EQ(found,(std::vector<size_t>{2,3,4}));
+	EXPECT_FALSE(index.overlaps(PSegment(6,9)));
+}
+RC_GTEST_PROP(SegmentIndex,query_reports_exactly_the_overlapping_segments,(const std::vector<PSegment>& segments, const PSegment& box)){
+	bor::vector<PSegment> vec(segments);
+	SegmentIndex<PSegment> index(vec);
+	std::vector<size_t> expected;
+	for(size_t i = 0; i < segments.size(); ++i){
+		if(!intersect(segments[i],box).empty())expected.push_back(i);
+	}
+	std::vector<size_t> found;
+	index.query(box,[&](const PSegment& seg, size_t id){
+				RC_ASSERT(seg == segments[id]);
+				found.push_back(id);
+				return true;
+			});
+	std::sort(found.begin(),found.end());
+	RC_ASSERT(found == expected);
+	RC_ASSERT(index.overlaps(box) == !expected.empty());
+}
+RC_GTEST_PROP(SegmentIndex,query_stops_when_callback_returns_false,(const std::vector<PSegment>& segments)){
+	bor::vector<PSegment> vec(segments);
+	SegmentIndex<PSegment> index(vec);
+	size_t calls = 0;
+	bool completed = index.query(PSegment{},[&](const PSegment&, size_t){
+				calls++;
+				return false;
+			});
+	RC_ASSERT(calls == (segments.empty() ? 0u : 1u));
+	RC_ASSERT(completed == segments.empty());
+}
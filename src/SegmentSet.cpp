@@ -3,6 +3,8 @@
 #include "util.hpp"
 #include <omp.h>
 #include <ranges>
+#include <algorithm>
+#include <chrono>
 
 template<typename T>
 void multi_vector_merge(bor::vector<T>& target, const bor::vector<bor::vector<T>>& partial){
@@ -46,30 +48,87 @@ template<typename segment_t>
 void SegmentSet<segment_t>::UNION_par(const SegmentSet<segment_t>& other){
 	bor::vector<bor::vector<segment_t>> partial = {std::move(segments),other.segments};
 	multi_vector_merge(segments,partial);
+	modified();
 }
 template<typename segment_t>
 void SegmentSet<segment_t>::UNION_seq(const SegmentSet<segment_t>& other){
-	std::copy(
-			other.segments.begin(),
-			other.segments.end(),
-			std::back_inserter(segments));
+	segments.insert_back(other.segments.begin(),other.segments.end());
+	modified();
 }
 template<typename segment_t>
 bool SegmentSet<segment_t>::isEmpty() const noexcept{
 	return segments.empty();
 }
+template<typename segment_t>
+bool SegmentSet<segment_t>::intersects(const SegmentSet<segment_t>& other) const{
+	if(other.hasIndex()){
+		return std::ranges::any_of(segments,[&other](const segment_t& seg){
+					return other.index_m->overlaps(seg);
+				});
+	}
+	if(hasIndex()){
+		return other.intersects(*this);
+	}
+	for(const auto& seg1 : segments){
+		for(const auto& seg2 : other.segments){
+			if(seg1.overlaps(seg2))return true;
+		}
+	}
+	return false;
+}
+template<typename segment_t>
+bool SegmentSet<segment_t>::isSubsetOf(const SegmentSet<segment_t>& other) const{
+	return std::ranges::all_of(segments,[&other](const segment_t& seg){
+				return seg.empty() || coveredBy(seg,other.segments,0);
+			});
+}
+template<typename segment_t>
+bool SegmentSet<segment_t>::coveredBy(segment_t seg, const bor::vector<segment_t>& other, size_t from){
+	size_t j = from;
+	while(j < other.size() && !seg.overlaps(other[j]))++j;
+	if(j == other.size())return false;
+	//the parts of seg outside of other[j] have to be covered by the following segments
+	const auto& cover = other[j];
+	bool covered = true;
+	util::constexpr_for<0,segment_t::dimensions,1>([&](auto dim){
+				if(!covered)return;
+				auto& start = seg.template getStart<dim>();
+				auto& end = seg.template getEnd<dim>();
+				auto cover_start = cover.template getStart<dim>();
+				auto cover_end = cover.template getEnd<dim>();
+				if(start < cover_start){
+					auto piece = seg;
+					piece.template getEnd<dim>() = cover_start-1;
+					covered = coveredBy(piece,other,j+1);
+					start = cover_start;
+				}
+				if(covered && end > cover_end){
+					auto piece = seg;
+					piece.template getStart<dim>() = cover_end+1;
+					covered = coveredBy(piece,other,j+1);
+					end = cover_end;
+				}
+			});
+	return covered;
+}
 PSegment::PSegment(const PSegment_type& other) : PSegment_type(other) {}
 std::ostream& operator<<(std::ostream& out,const PSegment& segment){
 	return out << PSegment_type(segment);
 }
+CSegment::CSegment(const CSegment_type& other) : CSegment_type(other) {}
+std::ostream& operator<<(std::ostream& out,const CSegment& segment){
+	return out << CSegment_type(segment);
+}
 template<typename segment_t>
 gmp::BigInt SegmentSet<segment_t>::getAmountPointsExaktSafe() {
+	//canonical segments are disjoint
+	if(canonical_m)return getAmountPointsExakt();
 	compact();
 
 	gmp::BigInt ret = 0;
 	for(size_t i = 0; i < segments.size(); i++){
 		ret += segments[i].getAmountPointsExakt();
-		PSET intersections;
+		SegmentSet intersections;
 
 		for(size_t j = i+1; j < segments.size(); j++){
 			auto intersection = intersect(segments[i],segments[j]);
@@ -112,30 +171,34 @@ template<typename segment_t>
 void SegmentSet<segment_t>::INTERSECTION_NEGATED_par(const SegmentSet& other){
 	auto negated = other;
 	negated.NEGATE_seq();
-	bor::vector<bor::vector<PSegment>> partial;
-	std::vector<std::atomic<bool>> intersects(segments.size());
+	//the threads only read, they must not detach shared storage concurrently
+	const auto& input = segments;
+	bor::vector<bor::vector<segment_t>> partial;
+	std::vector<std::atomic<bool>> intersects(input.size());
 #pragma omp parallel
 	{
 #pragma omp single
 		{
+			//the buffers grow concurrently, an arena of the calling thread can't serve them
+			bor::resource_scope scope(bor::heap_resource());
 			partial.resize(omp_get_num_threads());
 		}
 #pragma omp for collapse(2)
-	for(size_t i = 0; i < segments.size(); ++i){
+	for(size_t i = 0; i < input.size(); ++i){
 		for(size_t j = 0; j < other.segments.size(); ++j){
-			if(!intersect(segments[i],other.segments[j]).empty()){
+			if(!intersect(input[i],other.segments[j]).empty()){
 				intersects[i] = true;
 			}
 		}
 	}
 #pragma omp barrier
 #pragma omp for 
-	for(size_t i = 0; i < segments.size(); ++i){
+	for(size_t i = 0; i < input.size(); ++i){
 		if(!intersects[i]){
-			partial[omp_get_thread_num()].push_back(segments[i]);
+			partial[omp_get_thread_num()].push_back(input[i]);
 		}else{
 			for(size_t j = 0; j < negated.segments.size(); ++j){
-				auto intersection = intersect(segments[i],negated.segments[j]);
+				auto intersection = intersect(input[i],negated.segments[j]);
 				if(intersection.empty()) continue;
 				partial[omp_get_thread_num()].push_back(intersection);
 			}
@@ -144,22 +207,47 @@ void SegmentSet<segment_t>::INTERSECTION_NEGATED_par(const SegmentSet& other){
 	}
 
 	multi_vector_merge(segments,partial);
+	modified();
 }
 template<typename segment_t>
 void SegmentSet<segment_t>::INTERSECTION_NEGATED_seq(const SegmentSet& other){
 	auto negated = other;
 	negated.NEGATE_seq();
-	bor::vector<PSegment> result;
-	for(const auto& seg1 : segments){
+	if(negated.segments.size() >= index_threshold){
+		negated.buildIndex();
+	}
+	//sets too small for an index are still tested several segments at a time
+	SegmentColumns<segment_t> other_columns, negated_columns;
+	bool use_other_columns = !other.hasIndex() && other.segments.size() >= columns_threshold;
+	bool use_negated_columns = !negated.hasIndex() && negated.segments.size() >= columns_threshold;
+	if(use_other_columns)other_columns = SegmentColumns<segment_t>(other.segments);
+	if(use_negated_columns)negated_columns = SegmentColumns<segment_t>(negated.segments);
+	bor::vector<segment_t> result;
+	for(const auto& seg1 : std::as_const(segments)){
 		bool intersects = false;
-		for(const auto& seg2 : other.segments){
-			if(!intersect(seg1,seg2).empty()){
-				intersects = true;
-				break;
+		if(other.hasIndex()){
+			intersects = other.index_m->overlaps(seg1);
+		}else if(use_other_columns){
+			intersects = other_columns.overlaps(seg1);
+		}else{
+			for(const auto& seg2 : other.segments){
+				if(!intersect(seg1,seg2).empty()){
+					intersects = true;
+					break;
+				}
 			}
 		}
 		if(!intersects){
 			result.push_back(seg1);
+		}else if(negated.hasIndex()){
+			negated.index_m->query(seg1,[&](const segment_t& seg2, size_t){
+						result.push_back(intersect(seg1,seg2));
+						return true;
+					});
+		}else if(use_negated_columns){
+			for(size_t j = negated_columns.nextOverlap(seg1); j < negated_columns.size(); j = negated_columns.nextOverlap(seg1,j+1)){
+				result.push_back(intersect(seg1,negated.segments[j]));
+			}
 		}else{
 			for(const auto& seg2 : negated.segments){
 				auto intersection = intersect(seg1,seg2);
@@ -171,20 +259,25 @@ void SegmentSet<segment_t>::INTERSECTION_NEGATED_seq(const SegmentSet& other){
 	}
 
 	segments = std::move(result);
+	modified();
 }
 template<typename segment_t>
 void SegmentSet<segment_t>::INTERSECTION_par(const SegmentSet& other){
+	//the threads only read, they must not detach shared storage concurrently
+	const auto& input = segments;
 	bor::vector<bor::vector<segment_t>> partial;
 #pragma omp parallel 
 	{
 #pragma omp single
 		{
+			//the buffers grow concurrently, an arena of the calling thread can't serve them
+			bor::resource_scope scope(bor::heap_resource());
 			partial.resize(omp_get_num_threads());
 		}
 #pragma omp for collapse(2)
-		for(size_t i = 0; i < segments.size(); i++){
+		for(size_t i = 0; i < input.size(); i++){
 			for(size_t j = 0; j < other.segments.size(); j++){
-				auto intersection = intersect(segments[i],other.segments[j]);
+				auto intersection = intersect(input[i],other.segments[j]);
 				if(!intersection.empty()){
 					partial[omp_get_thread_num()].push_back(intersection);
 				}
@@ -192,25 +285,105 @@ void SegmentSet<segment_t>::INTERSECTION_par(const SegmentSet& other){
 		}
 	}
 	multi_vector_merge(segments,partial);
+	modified();
 }
 
 template<typename segment_t>
 void SegmentSet<segment_t>::INTERSECTION(const SegmentSet& other){
-	INTERSECTION_seq(other);
+	if(other.hasIndex() && other.segments.size() >= index_threshold){
+		INTERSECTION_indexed(other);
+	}else if(hasIndex() && segments.size() >= index_threshold){
+		//the intersection commutes, so the own index can be queried with the segments of other
+		segments = intersectIndexed(other.segments,*index_m);
+		modified();
+	}else{
+		INTERSECTION_sweep(other);
+	}
+}
+template<typename segment_t>
+auto SegmentSet<segment_t>::intersectIndexed(const bor::vector<segment_t>& queries, const SegmentIndex<segment_t>& index) -> bor::vector<segment_t> {
+	bor::vector<segment_t> result;
+	for(const auto& seg1 : queries){
+		index.query(seg1,[&](const segment_t& seg2, size_t){
+					result.push_back(intersect(seg1,seg2));
+					return true;
+				});
+	}
+	return result;
+}
+template<typename segment_t>
+void SegmentSet<segment_t>::INTERSECTION_indexed(const SegmentSet& other){
+	auto index = other.index_m;
+	if(!other.hasIndex()){
+		index = std::make_shared<const SegmentIndex<segment_t>>(other.segments);
+	}
+	segments = intersectIndexed(segments,*index);
+	modified();
 }
 template<typename segment_t>
 void SegmentSet<segment_t>::INTERSECTION_seq(const SegmentSet& other){
 	bor::vector<segment_t> result;
-	for(size_t i = 0; i < segments.size(); i++){
-		for(size_t j = 0; j < other.segments.size(); j++){
-			auto intersection = intersect(segments[i],other.segments[j]);
+	for(const auto& seg1 : std::as_const(segments)){
+		for(const auto& seg2 : other.segments){
+			auto intersection = intersect(seg1,seg2);
 			if(intersection.empty()) continue;
 			result.push_back(intersection);
 		}
 	}
 	segments = std::move(result);
+	modified();
 }
 
+template<typename segment_t>
+void SegmentSet<segment_t>::INTERSECTION_sweep(const SegmentSet& other){
+	if(segments.size()*other.segments.size() <= sweep_threshold){
+		INTERSECTION_seq(other);
+		return;
+	}
+	auto sortedByStart = [](const bor::vector<segment_t>& segs){
+		bor::vector<const segment_t*> ret;
+		ret.reserve(segs.size());
+		for(const auto& seg : segs)ret.push_back(&seg);
+		std::ranges::sort(ret,[](const segment_t* s1, const segment_t* s2){
+					return s1->template getStart<0>() < s2->template getStart<0>();
+				});
+		return ret;
+	};
+	auto lhs = sortedByStart(segments);
+	auto rhs = sortedByStart(other.segments);
+
+	bor::vector<segment_t> result;
+	bor::vector<const segment_t*> active_lhs, active_rhs;
+	//intersects seg with every active segment of the other set
+	//segments ending before seg starts can't overlap anything that follows and are dropped
+	auto sweep = [&result](const segment_t* seg, bor::vector<const segment_t*>& active){
+		auto start = seg->template getStart<0>();
+		for(size_t k = 0; k < active.size();){
+			if(active[k]->template getEnd<0>() < start){
+				active[k] = active.back();
+				active.pop_back();
+				continue;
+			}
+			auto intersection = intersect(*seg,*active[k]);
+			if(!intersection.empty()){
+				result.push_back(intersection);
+			}
+			++k;
+		}
+	};
+	size_t i = 0, j = 0;
+	while(i < lhs.size() || j < rhs.size()){
+		if(j == rhs.size() || (i < lhs.size() && lhs[i]->template getStart<0>() <= rhs[j]->template getStart<0>())){
+			sweep(lhs[i],active_rhs);
+			active_lhs.push_back(lhs[i++]);
+		}else{
+			sweep(rhs[j],active_lhs);
+			active_rhs.push_back(rhs[j++]);
+		}
+	}
+	segments = std::move(result);
+	modified();
+}
 
 
 
@@ -220,25 +393,27 @@ void SegmentSet<segment_t>::NEGATE(){
 }
 template<typename segment_t>
 void SegmentSet<segment_t>::NEGATE_par(){
+	modified();
 	if(isEmpty()){
 		segments.emplace_back();
 		return;
 	}
-	SegmentSet<segment_t> result = negate(segments[0]);
+	SegmentSet<segment_t> result = negate(std::as_const(segments)[0]);
 	for(size_t i = 1; i < segments.size(); ++i){
-		result.INTERSECTION_NEGATED_par(bor::vector{segments[i]});
+		result.INTERSECTION_NEGATED_par(bor::vector{std::as_const(segments)[i]});
 	}
 	segments = std::move(result.segments);
 }
 template<typename segment_t>
 void SegmentSet<segment_t>::NEGATE_seq(){
+	modified();
 	if(isEmpty()){
 		segments.emplace_back();
 		return;
 	}
-	SegmentSet<segment_t> result = negate(segments[0]);
+	SegmentSet<segment_t> result = negate(std::as_const(segments)[0]);
 	SegmentSet<segment_t> temp;
-	for(const auto& segment : segments | std::views::drop(1)){
+	for(const auto& segment : std::as_const(segments) | std::views::drop(1)){
 		temp.segments.clear();
 		temp.segments.push_back(segment);
 		result.INTERSECTION_NEGATED_seq(temp);
@@ -246,6 +421,164 @@ void SegmentSet<segment_t>::NEGATE_seq(){
 	segments = std::move(result.segments);
 }
 
+template<typename segment_t>
+void SegmentSet<segment_t>::NEGATE_cells(){
+	segments = decompose<false>();
+	modified();
+	canonical_m = true;
+}
+template<typename segment_t>
+void SegmentSet<segment_t>::canonicalize(){
+	if(canonical_m)return;
+	segments = decompose<true>();
+	modified();
+	canonical_m = true;
+}
+template<typename segment_t>
+bool SegmentSet<segment_t>::isCanonical() const noexcept{
+	return canonical_m;
+}
+template<typename segment_t>
+auto SegmentSet<segment_t>::pack(typename PackedSegments<segment_t>::Encoding encoding) const -> PackedSegments<segment_t> {
+	return PackedSegments<segment_t>(segments,encoding);
+}
+template<typename segment_t>
+auto SegmentSet<segment_t>::unpack(const PackedSegments<segment_t>& packed, bool canonical) -> SegmentSet {
+	SegmentSet ret(packed.unpack());
+	ret.canonical_m = canonical;
+	return ret;
+}
+template<typename segment_t>
+auto SegmentSet<segment_t>::fromCanonical(bor::vector<segment_t>&& segments) -> SegmentSet {
+	SegmentSet ret(std::move(segments));
+	ret.canonical_m = true;
+	return ret;
+}
+template<typename segment_t>
+size_t SegmentSet<segment_t>::hash() const noexcept{
+	size_t ret = segments.size();
+	auto combine = [&ret](size_t value){
+		ret ^= value + 0x9e3779b97f4a7c15ull + (ret << 6) + (ret >> 2);
+	};
+	for(const auto& seg : segments){
+		util::constexpr_for<0,segment_t::dimensions,1>([&](auto dim){
+					combine(seg.template getStart<dim>());
+					combine(seg.template getEnd<dim>());
+				});
+	}
+	return ret;
+}
+template<typename segment_t>
+void SegmentSet<segment_t>::modified(){
+	index_m.reset();
+	canonical_m = false;
+}
+template<typename segment_t>
+template<bool covered>
+auto SegmentSet<segment_t>::decompose() const -> bor::vector<segment_t> {
+	//pointers into segments, so sorting them restores the order of segments
+	std::vector<const segment_t*> covering;
+	covering.reserve(segments.size());
+	for(const auto& seg : segments){
+		if(!seg.empty())covering.push_back(&seg);
+	}
+	cell_memo_t memo;
+	return cells<covered,0>(covering,memo);
+}
+/**
+ * @returns sorted disjoint segments covering everything in dimensions >= dim\n
+ * that is covered (or not covered) by @b covering\n
+ * all dimensions < dim are left at their maximum size\n
+ * the returned vector lives as long as @b memo
+ */
+template<typename segment_t>
+template<bool covered, int dim>
+auto SegmentSet<segment_t>::cells(const std::vector<const segment_t*>& covering, cell_memo_t& memo) -> const bor::vector<segment_t>& {
+	//the first call may happen inside an arena, the constants outlive it
+	static const bor::vector<segment_t> everything = [](){
+				bor::vector<segment_t> ret(bor::heap_resource());
+				ret.push_back(segment_t{});
+				return ret;
+			}();
+	static const bor::vector<segment_t> nothing(bor::heap_resource());
+	if(covering.empty())return covered ? nothing : everything;
+	if constexpr(dim == segment_t::dimensions){
+		return covered ? everything : nothing;
+	}else{
+		//the same covering segments are reached through many cells of the previous dimensions
+		auto memoized = memo[dim].find(covering);
+		if(memoized != memo[dim].end())return memoized->second;
+		bor::vector<segment_t> ret;
+		using dimension_t = std::remove_cvref_t<decltype(covering[0]->template getStart<dim>())>;
+		//every cut starts an interval, intervals are never split by any segment
+		std::vector<dimension_t> cuts;
+		cuts.reserve(2*covering.size()+1);
+		cuts.push_back(std::numeric_limits<dimension_t>::min());
+		for(auto seg : covering){
+			cuts.push_back(seg->template getStart<dim>());
+			if(seg->template getEnd<dim>() != std::numeric_limits<dimension_t>::max()){
+				cuts.push_back(seg->template getEnd<dim>()+1);
+			}
+		}
+		std::ranges::sort(cuts);
+		cuts.erase(std::unique(cuts.begin(),cuts.end()),cuts.end());
+		auto by_start = covering;
+		std::ranges::sort(by_start,[](const segment_t* s1, const segment_t* s2){
+					return s1->template getStart<dim>() < s2->template getStart<dim>();
+				});
+
+		//cells of the previous intervals that are still extended, sorted by cell
+		std::vector<std::pair<segment_t,dimension_t>> open, next_open;
+		std::vector<const segment_t*> active, prev_active;
+		auto close = [&ret](segment_t cell, dimension_t start, dimension_t end){
+			cell.template setInterval<dim>(start,end);
+			ret.push_back(cell);
+		};
+		size_t next_start = 0;
+		for(size_t k = 0; k < cuts.size(); ++k){
+			dimension_t start = cuts[k];
+			//a segment covers the whole interval as soon as it contains its start
+			std::erase_if(active,[start](const segment_t* seg){
+						return seg->template getEnd<dim>() < start;
+					});
+			bool added = false;
+			for(; next_start < by_start.size() && by_start[next_start]->template getStart<dim>() <= start; ++next_start){
+				active.push_back(by_start[next_start]);
+				added = true;
+			}
+			if(added)std::ranges::sort(active);
+			//the same covering segments leave the same cells, which just extend the open ones
+			if(k != 0 && active == prev_active)continue;
+			prev_active = active;
+			const auto& next_cells = cells<covered,dim+1>(active,memo);
+			//cells present in this and the previous interval are merged
+			next_open.clear();
+			size_t i = 0, j = 0;
+			while(i < open.size() || j < next_cells.size()){
+				if(j == next_cells.size() || (i < open.size() && open[i].first < next_cells[j])){
+					close(open[i].first,open[i].second,start-1);
+					++i;
+				}else if(i == open.size() || next_cells[j] < open[i].first){
+					next_open.emplace_back(next_cells[j++],start);
+				}else{
+					next_open.push_back(open[i++]);
+					++j;
+				}
+			}
+			std::swap(open,next_open);
+		}
+		for(const auto& [cell,start] : open){
+			close(cell,start,std::numeric_limits<dimension_t>::max());
+		}
+		//cells are closed ordered by end and the remaining dimensions,
+		//so ordering by start keeps ret sorted like the cells of the next dimension
+		std::stable_sort(ret.begin(),ret.end(),[](const segment_t& s1, const segment_t& s2){
+					return s1.template getStart<dim>() < s2.template getStart<dim>();
+				});
+		return memo[dim].emplace(covering,std::move(ret)).first->second;
+	}
+}
+
 template<typename segment_t>
 std::ostream& operator<<(std::ostream& out,const SegmentSet<segment_t>& ip_set){
 	out << '{' << std::endl;
@@ -256,35 +589,127 @@ std::ostream& operator<<(std::ostream& out,const SegmentSet<segment_t>& ip_set){
 	return out;
 }
 template std::ostream& operator<<(std::ostream& out,const PSET& ip_set);
+template std::ostream& operator<<(std::ostream& out,const CSET& ip_set);
+
+//!lexicographic order over all dimensions but skip, ties are broken by the start of skip
+template<int skip, typename segment_t>
+static bool lessExcept(const segment_t& s1, const segment_t& s2){
+	int cmp = 0;
+	util::constexpr_for<0,segment_t::dimensions,1>([&](auto dim){
+				if(dim == skip || cmp != 0)return;
+				if(s1.template getStart<dim>() != s2.template getStart<dim>()){
+					cmp = s1.template getStart<dim>() < s2.template getStart<dim>() ? -1 : 1;
+				}else if(s1.template getEnd<dim>() != s2.template getEnd<dim>()){
+					cmp = s1.template getEnd<dim>() < s2.template getEnd<dim>() ? -1 : 1;
+				}
+			});
+	if(cmp != 0)return cmp < 0;
+	return s1.template getStart<skip>() < s2.template getStart<skip>();
+}
+template<int skip, typename segment_t>
+static bool equalExcept(const segment_t& s1, const segment_t& s2){
+	bool equal = true;
+	util::constexpr_for<0,segment_t::dimensions,1>([&](auto dim){
+				if(dim == skip)return;
+				equal = equal
+					&& s1.template getStart<dim>() == s2.template getStart<dim>()
+					&& s1.template getEnd<dim>() == s2.template getEnd<dim>();
+			});
+	return equal;
+}
 
 template<typename segment_t>
 void SegmentSet<segment_t>::compact(){
-
+	compact(compact_budget{});
+}
+template<typename segment_t>
+void SegmentSet<segment_t>::compact(const compact_budget& budget){
+	//canonical segments neither contain each other nor are they mergeable
+	if(canonical_m)return;
+	//mergeNeighbours reorders the segments, so the ids of an index don't match them anymore
+	index_m.reset();
+	auto begin = std::chrono::steady_clock::now();
+	auto out_of_time = [&](){
+		auto elapsed = std::chrono::steady_clock::now()-begin;
+		return std::chrono::duration_cast<std::chrono::milliseconds>(elapsed) >= budget.max_time;
+	};
+	bool changed = true;
+	for(size_t pass = 0; changed && pass < budget.max_passes && !out_of_time(); ++pass){
+		changed = false;
+		util::constexpr_for<0,segment_t::dimensions,1>([&](auto dim){
+					if(out_of_time())return;
+					changed |= mergeNeighbours<dim>();
+				});
+		//merging first folds equal segments, which would all overlap each other in the index
+		if(!out_of_time())changed |= removeContained();
+	}
+	modified();
+}
+template<typename segment_t>
+bool SegmentSet<segment_t>::removeContained(){
+	//of equal segments the first one is kept
+	auto index = index_m;
+	if(!hasIndex()){
+		index = std::make_shared<const SegmentIndex<segment_t>>(segments);
+	}
+	std::vector<bool> removed(segments.size());
 	for(size_t i = 0; i < segments.size(); i++){
-		for(size_t j = i+1; j < segments.size(); j++){
-
-			auto intersection = intersect(segments[i],segments[j]);
-			if(segments[i] == intersection){
-				std::swap(segments[i],segments.back());
-				segments.pop_back();
-				j = i;
-			}
-			else if(segments[j] == intersection){
-				std::swap(segments[j],segments.back());
-				segments.pop_back();
-				--j;
-			}
-		}
+		const auto& seg = std::as_const(segments)[i];
+		index->query(seg,[&](const segment_t& other, size_t j){
+					if(j == i || removed[j])return true;
+					if(intersect(seg,other) == seg && (!(seg == other) || j < i)){
+						removed[i] = true;
+						return false;
+					}
+					return true;
+				});
 	}
+	//the index shares the storage of segments, which would be copied by the writes below
+	index.reset();
+	index_m.reset();
+	size_t kept = 0;
 	for(size_t i = 0; i < segments.size(); i++){
-		for(size_t j = i+1; j < segments.size(); j++){
-			if(segments[i].mergeable(segments[j])){
-				segments[i] = segments[i].merge(segments[j]);
-				std::swap(segments[j],segments.back());
-				segments.pop_back();
-				--j;
+		if(!removed[i])segments[kept++] = segments[i];
+	}
+	bool changed = kept != segments.size();
+	segments.resize(kept);
+	return changed;
+}
+template<typename segment_t>
+template<int dim>
+bool SegmentSet<segment_t>::mergeNeighbours(){
+	using dimension_t = std::remove_cvref_t<decltype(segments[0].template getStart<dim>())>;
+	//segments only differing in dim end up next to each other ordered by their start in dim
+	std::sort(segments.begin(),segments.end(),lessExcept<dim,segment_t>);
+	size_t kept = 0;
+	for(size_t i = 0; i < segments.size(); i++){
+		if(kept != 0){
+			auto& prev = segments[kept-1];
+			const auto& seg = segments[i];
+			auto prev_end = prev.template getEnd<dim>();
+			//overlapping or touching intervals
+			if(equalExcept<dim>(prev,seg)
+					&& (prev_end == std::numeric_limits<dimension_t>::max() || seg.template getStart<dim>() <= prev_end+1)){
+				prev.template getEnd<dim>() = std::max(prev_end,seg.template getEnd<dim>());
+				continue;
 			}
 		}
+		segments[kept++] = segments[i];
 	}
+	bool changed = kept != segments.size();
+	segments.resize(kept);
+	return changed;
+}
 
+template<typename segment_t>
+void SegmentSet<segment_t>::buildIndex(){
+	index_m = std::make_shared<const SegmentIndex<segment_t>>(segments);
+}
+template<typename segment_t>
+void SegmentSet<segment_t>::dropIndex(){
+	index_m.reset();
+}
+template<typename segment_t>
+bool SegmentSet<segment_t>::hasIndex() const noexcept{
+	return index_m != nullptr && index_m->indexes(segments);
 }
@@ -2,7 +2,17 @@
 #include "util.hpp"
 #include "vector.hpp"
 #include "Segment.hpp"
+#include "SegmentIndex.hpp"
+#include "SegmentColumns.hpp"
+#include "PackedSegments.hpp"
 #include <vector>
+#include <memory>
+#include <map>
+#include <array>
+#include <algorithm>
+#include <chrono>
+#include <utility>
+#include <limits>
 #include <iostream>
 
 using PSegment_type = Segment<uint32_t,uint32_t,uint16_t,uint16_t,uint8_t,uint8_t,uint8_t>;
@@ -30,6 +40,19 @@ class PSegment : public PSegment_type {
 
 	friend std::ostream& operator<<(std::ostream&,const PSegment&);
 };
+using CSegment_type = Segment<uint16_t,uint16_t,uint16_t,uint16_t,uint8_t,uint8_t,uint8_t>;
+/**
+ * @brief a PSegment whose intervals are ranks of the intervals of a CoordinateCompression
+ * @details the dimensions are indexed like the ones of PSegment e.g. getStart<PSegment::SRC_IP_INDEX>()
+ * @sa CSET
+ */
+class CSegment : public CSegment_type {
+	public:
+	using CSegment_type::CSegment_type;
+	CSegment(const CSegment_type&);
+
+	friend std::ostream& operator<<(std::ostream&,const CSegment&);
+};
 /**
  * @brief Compression Datastructure for arbitrary sets of points
  * @details SegmentSet expects a derived type of Segment as segment_t\n
@@ -60,6 +83,20 @@ public:
 	auto INTERSECTION(const SegmentSet&) -> void;
 	auto INTERSECTION_par(const SegmentSet&) -> void;
 	auto INTERSECTION_seq(const SegmentSet&) -> void;
+	/**
+	 * sorts both sets on the first dimension and sweeps over them\n
+	 * only segments whose first-dimension intervals overlap are intersected\n
+	 * falls back to INTERSECTION_seq if n*m <= sweep_threshold\n
+	 * runtime O((n+m)*log(n+m)+k) with k overlapping pairs in the first dimension
+	 */
+	auto INTERSECTION_sweep(const SegmentSet&) -> void;
+	constexpr static size_t sweep_threshold = 64;
+	/**
+	 * queries the SegmentIndex of @b other once per segment of this set\n
+	 * an index is built temporarily if @b other doesn't carry one\n
+	 * runtime O(n*log(m)+k) for small segments, k being the size of the result
+	 */
+	auto INTERSECTION_indexed(const SegmentSet&) -> void;
 	/**
 	 * the resulting set contains all points previously not contained\n
 	 * in the set that are represntable by segment_t\n
@@ -68,6 +105,14 @@ public:
 	auto NEGATE() -> void;
 	auto NEGATE_par() -> void;
 	auto NEGATE_seq() -> void;
+	/**
+	 * splits every dimension at the boundaries of the segments\n
+	 * and emits the cells not covered by any segment\n
+	 * neighbouring cells with the same uncovered remainder are merged\n
+	 * the result is canonical\n
+	 * runtime O(n^2*c) with c cells visited, output sensitive instead of O(d^n)
+	 */
+	auto NEGATE_cells() -> void;
 
 	/**
 	 * the resulting set contains all points previously not contained\n
@@ -77,6 +122,11 @@ public:
 	auto INTERSECTION_NEGATED(const SegmentSet&) -> void;
 	auto INTERSECTION_NEGATED_par(const SegmentSet&) -> void;
 	auto INTERSECTION_NEGATED_seq(const SegmentSet&) -> void;
+	/**
+	 * sets without an index but at least columns_threshold segments\n
+	 * are copied into SegmentColumns by INTERSECTION_NEGATED_seq
+	 */
+	constexpr static size_t columns_threshold = 32;
 
 	auto getAmountPoints() const -> long double;
 	auto getAmountPointsExakt() const -> gmp::BigInt;
@@ -87,15 +137,100 @@ public:
 	 */
 	[[nodiscard]]
 	auto isEmpty() const noexcept -> bool;
+	/**
+	 * @return whether both sets have at least one point in common\n
+	 * equivalent to !INTERSECTION(*this,other).isEmpty() but stops at the first overlap\n
+	 * and doesn't allocate\n
+	 * runtime O(n*m), O(n*log(m)) or O(m*log(n)) if one of the sets has an index
+	 */
+	[[nodiscard]]
+	auto intersects(const SegmentSet&) const -> bool;
+	/**
+	 * @return whether all points of this set are contained in @b other\n
+	 * equivalent to INTERSECTION_NEGATED(*this,other).isEmpty()\n
+	 * but stops at the first uncovered point and doesn't allocate\n
+	 * runtime O(n*d^m) in the worst case
+	 */
+	[[nodiscard]]
+	auto isSubsetOf(const SegmentSet& other) const -> bool;
 
+	/**
+	 * limits the effort compact spends, whichever limit is reached first stops it
+	 */
+	struct compact_budget {
+		size_t max_passes = std::numeric_limits<size_t>::max();
+		std::chrono::milliseconds max_time = std::chrono::milliseconds::max();
+	};
 	/**
 	 * since the internal representation of a SegmentSet is not unique\n
 	 * algorithms can lead to segmentation which will lead to slowdown or\n
 	 * exceeding the memory limit\n
 	 * this method will try to reduce the number of segments in the current state\n
-	 * runtime O(n^2)\n
+	 * every pass sorts the segments once per dimension by all other dimensions\n
+	 * merging neighbours that only differ in overlapping or touching intervals of that dimension\n
+	 * and then removes segments contained in others\n
+	 * passes are repeated until nothing changes or the budget is used up\n
+	 * runtime O(p*d*n*log(n)) with p passes\n
 	 * */
 	void compact();
+	void compact(const compact_budget&);
+
+	/**
+	 * replaces the segments with the canonical representation of the contained points\n
+	 * the segments of a canonical set are disjoint, sorted and maximally merged\n
+	 * two canonical sets contain the same points exactly if their segments are equal\n
+	 * the set stays canonical until it is modified\n
+	 * runtime O(n^2*c) with c cells visited, see NEGATE_cells
+	 */
+	void canonicalize();
+	[[nodiscard]]
+	auto isCanonical() const noexcept -> bool;
+	/**
+	 * @return hash of the segments in their current order\n
+	 * canonical sets containing the same points have the same hash\n
+	 * runtime O(n)
+	 */
+	[[nodiscard]]
+	auto hash() const noexcept -> size_t;
+	/**
+	 * @return the segments in a padding free encoding for long term storage\n
+	 * the DELTA encoding is smallest for canonical sets\n
+	 * runtime O(n)
+	 */
+	[[nodiscard]]
+	auto pack(typename PackedSegments<segment_t>::Encoding encoding = PackedSegments<segment_t>::Encoding::FIXED) const -> PackedSegments<segment_t>;
+	/**
+	 * @return the set of the packed segments\n
+	 * @param canonical whether the packed set was canonical\n
+	 * runtime O(n)
+	 */
+	[[nodiscard]]
+	static auto unpack(const PackedSegments<segment_t>& packed, bool canonical = false) -> SegmentSet;
+	/**
+	 * @return the set of segments taken from a canonical set\n
+	 * without canonicalizing them again
+	 */
+	[[nodiscard]]
+	static auto fromCanonical(bor::vector<segment_t>&& segments) -> SegmentSet;
+
+	/**
+	 * bulk loads a SegmentIndex over the current segments\n
+	 * INTERSECTION and INTERSECTION_NEGATED will use it\n
+	 * as long as the set has at least index_threshold segments and isn't modified\n
+	 * copies of the set share the index\n
+	 * the index shares the storage of @b segments, so writing to them detaches them from it and drops the index\n
+	 * code that modifies @b segments directly still has to call modified afterwards for the canonical flag\n
+	 * runtime O(n*log(n))
+	 */
+	void buildIndex();
+	void dropIndex();
+	/**
+	 * drops the index and the canonical flag
+	 */
+	void modified();
+	[[nodiscard]]
+	auto hasIndex() const noexcept -> bool;
+	constexpr static size_t index_threshold = 256;
 
 	/**
 	 * this function aids in construction of SegmentSets\n
@@ -140,40 +275,36 @@ public:
 		for(size_t i = 0; i < ranges.size(); ++i){
 			auto [start,end] = ranges[i];
 			for(size_t j = 0; j < prevSize; ++j){
-				PSegment next = this->segments[j];
-				next.setInterval<range_index>(start,end);
+				segment_t next = std::as_const(this->segments)[j];
+				next.template setInterval<range_index>(start,end);
 				ret.push_back(next);
 			}
 		}
 		*this = std::move(ret_set);
 	}
-	template<typename T>
-	friend SegmentSet<T> UNION(
-			const SegmentSet<T>& s1,
-			const SegmentSet<T>& s2){
+	friend SegmentSet UNION(
+			const SegmentSet& s1,
+			const SegmentSet& s2){
 		auto ret = s1;
 		ret.UNION(s2);
 		return ret;
 	}
-	template<typename T>
-	friend SegmentSet<T> NEGATION(
-			const SegmentSet<T>& s1){
+	friend SegmentSet NEGATION(
+			const SegmentSet& s1){
 		auto ret = s1;
 		ret.NEGATE();
 		return ret;
 	}
-	template<typename T>
-	friend SegmentSet<T> INTERSECTION_NEGATED(
-			const SegmentSet<T>& s1,
-			const SegmentSet<T>& s2){
+	friend SegmentSet INTERSECTION_NEGATED(
+			const SegmentSet& s1,
+			const SegmentSet& s2){
 		auto ret = s1;
 		ret.INTERSECTION_NEGATED(s2);
 		return ret;
 	}
-	template<typename T>
-	friend SegmentSet<T> INTERSECTION(
-			const SegmentSet<T>& s1,
-			const SegmentSet<T>& s2){
+	friend SegmentSet INTERSECTION(
+			const SegmentSet& s1,
+			const SegmentSet& s2){
 		auto ret = s1;
 		ret.INTERSECTION(s2);
 		return ret;
@@ -183,14 +314,34 @@ public:
 	friend std::ostream& operator<<(std::ostream&,const SegmentSet<T>&);
 
 	bor::vector<segment_t> segments;	
+private:
+	using cell_memo_t = std::array<std::map<std::vector<const segment_t*>,bor::vector<segment_t>>,segment_t::dimensions>;
+	//!@returns whether seg is covered by the segments of other starting at position from
+	static bool coveredBy(segment_t seg, const bor::vector<segment_t>& other, size_t from);
+	//!@returns whether a segment was removed
+	bool removeContained();
+	//!@returns whether a segment was merged
+	template<int dim>
+	bool mergeNeighbours();
+	template<bool covered>
+	auto decompose() const -> bor::vector<segment_t>;
+	template<bool covered, int dim>
+	static auto cells(const std::vector<const segment_t*>& covering, cell_memo_t& memo) -> const bor::vector<segment_t>&;
+	static auto intersectIndexed(const bor::vector<segment_t>& queries, const SegmentIndex<segment_t>& index) -> bor::vector<segment_t>;
+
+	std::shared_ptr<const SegmentIndex<segment_t>> index_m;
+	bool canonical_m = false;
 };
 
 /**
  * checks wheter these set contain exactly the same points\n
- * runtime O(n*d^m+m*d^n)
+ * runtime O(n*d^m+m*d^n), O(n) if both sets are canonical
  */
 template<typename segment_t>
 bool operator==(const SegmentSet<segment_t>& set1, const SegmentSet<segment_t>& set2) {
+	if(set1.isCanonical() && set2.isCanonical()){
+		return std::ranges::equal(set1.segments,set2.segments);
+	}
 	if(!INTERSECTION_NEGATED(set1,set2).isEmpty())return false;
 	if(!INTERSECTION_NEGATED(set2,set1).isEmpty())return false;
 	return true;
@@ -233,6 +384,8 @@ auto negate(const segment_t& segment) -> SegmentSet<segment_t> {
 //force instantiation
 template class SegmentSet<PSegment>;
 using PSET = SegmentSet<PSegment>;
+template class SegmentSet<CSegment>;
+using CSET = SegmentSet<CSegment>;
 
 template<typename ... Args>
 class fmt::formatter<Segment<Args...>>{
@@ -255,3 +408,5 @@ class fmt::formatter<Segment<Args...>>{
 
 template<>
 class fmt::formatter<PSegment> : public fmt::formatter<PSegment_type> {};
+template<>
+class fmt::formatter<CSegment> : public fmt::formatter<CSegment_type> {};
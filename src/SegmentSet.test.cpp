@@ -166,6 +166,108 @@ RC_GTEST_PROP(SegmentSet,INTERSECTION_par_vs_seq,(const PSET& set1, const PSET&
 	cpy2.INTERSECTION_seq(set2);
 	RC_ASSERT(cpy1 == cpy2);
 }
+RC_GTEST_PROP(SegmentSet,INTERSECTION_sweep_vs_seq,(const PSET& set1, const PSET& set2)){
+	auto cpy1 = set1;
+	auto cpy2 = set1;
+	cpy1.INTERSECTION_sweep(set2);
+	cpy2.INTERSECTION_seq(set2);
+	//both have to produce exactly the same segments, only the order may differ
+	std::vector<PSegment> res1(cpy1.segments.begin(),cpy1.segments.end());
+	std::vector<PSegment> res2(cpy2.segments.begin(),cpy2.segments.end());
+	std::sort(res1.begin(),res1.end());
+	std::sort(res2.begin(),res2.end());
+	RC_ASSERT(res1 == res2);
+}
+RC_GTEST_PROP(SegmentSet,INTERSECTION_sweep_overlapping_first_dimension,(const PSET& set1, const PSET& set2)){
+	//all segments share the first dimension so every pair has to be checked
+	auto cpy1 = set1;
+	auto cpy2 = set2;
+	for(auto& seg : cpy1.segments)seg.setInterval<0>(0,100);
+	for(auto& seg : cpy2.segments)seg.setInterval<0>(50,200);
+	auto expected = cpy1;
+	expected.INTERSECTION_seq(cpy2);
+	cpy1.INTERSECTION_sweep(cpy2);
+	RC_ASSERT(cpy1.segments.size() == expected.segments.size());
+	RC_ASSERT(cpy1 == expected);
+}
+RC_GTEST_PROP(SegmentSet,INTERSECTION_indexed_vs_seq,(const PSET& set1, const PSET& set2)){
+	auto cpy1 = set1;
+	auto cpy2 = set1;
+	cpy1.INTERSECTION_indexed(set2);
+	cpy2.INTERSECTION_seq(set2);
+	std::vector<PSegment> res1(cpy1.segments.begin(),cpy1.segments.end());
+	std::vector<PSegment> res2(cpy2.segments.begin(),cpy2.segments.end());
+	std::sort(res1.begin(),res1.end());
+	std::sort(res2.begin(),res2.end());
+	RC_ASSERT(res1 == res2);
+}
+RC_GTEST_PROP(SegmentSet,INTERSECTION_NEGATED_with_index_equal_to_without,(const PSET& set1, const PSET& set2)){
+	auto indexed = set2;
+	indexed.buildIndex();
+	RC_ASSERT(indexed.hasIndex());
+	auto cpy1 = set1;
+	auto cpy2 = set1;
+	cpy1.INTERSECTION_NEGATED(indexed);
+	cpy2.INTERSECTION_NEGATED(set2);
+	//the index only decides which segments intersect, the pieces are the same
+	std::vector<PSegment> res1(cpy1.segments.begin(),cpy1.segments.end());
+	std::vector<PSegment> res2(cpy2.segments.begin(),cpy2.segments.end());
+	std::sort(res1.begin(),res1.end());
+	std::sort(res2.begin(),res2.end());
+	RC_ASSERT(res1 == res2);
+}
+TEST(SegmentSet,index_is_dropped_on_modification){
+	PSET set(std::vector<PSegment>{PSegment(0,10),PSegment(20,30)});
+	set.buildIndex();
+	EXPECT_TRUE(set.hasIndex());
+	auto cpy = set;
+	EXPECT_TRUE(cpy.hasIndex());
+	cpy.INTERSECTION(PSET(std::vector<PSegment>{PSegment(5,25)}));
+	EXPECT_FALSE(cpy.hasIndex());
+	EXPECT_TRUE(set.hasIndex());
+	set.UNION(cpy);
+	EXPECT_FALSE(set.hasIndex());
+}
+TEST(SegmentSet,index_is_dropped_when_segments_are_written){
+	//the size stays the same, only the storage tells whether the segments changed
+	PSET set(std::vector<PSegment>{PSegment(0,10),PSegment(20,30)});
+	set.buildIndex();
+	auto cpy = set;
+	cpy.segments[0] = PSegment(40,50);
+	EXPECT_FALSE(cpy.hasIndex());
+	EXPECT_TRUE(set.hasIndex());
+	std::swap(set.segments[0],set.segments[1]);
+	EXPECT_FALSE(set.hasIndex());
+	EXPECT_FALSE(set.intersects(PSET(std::vector<PSegment>{PSegment(45,45)})));
+	EXPECT_TRUE(cpy.intersects(PSET(std::vector<PSegment>{PSegment(45,45)})));
+}
+RC_GTEST_PROP(SegmentSet,intersects_equal_to_INTERSECTION,(const PSET& set1, const PSET& set2)){
+	RC_ASSERT(set1.intersects(set2) == !INTERSECTION(set1,set2).isEmpty());
+	auto indexed = set2;
+	indexed.buildIndex();
+	RC_ASSERT(set1.intersects(indexed) == !INTERSECTION(set1,set2).isEmpty());
+	RC_ASSERT(indexed.intersects(set1) == !INTERSECTION(set1,set2).isEmpty());
+}
+RC_GTEST_PROP(SegmentSet,isSubsetOf_equal_to_INTERSECTION_NEGATED,(const PSET& set1, const PSET& set2)){
+	auto negated = set1;
+	negated.INTERSECTION_NEGATED(set2);
+	RC_ASSERT(set1.isSubsetOf(set2) == negated.isEmpty());
+	RC_ASSERT(set1.isSubsetOf(UNION(set1,set2)));
+	RC_ASSERT(INTERSECTION(set1,set2).isSubsetOf(set2));
+	auto split = set1;
+	split.NEGATE_cells();
+	split.NEGATE_cells();
+	RC_ASSERT(set1.isSubsetOf(split));
+	RC_ASSERT(split.isSubsetOf(set1));
+}
+TEST(SegmentSet,isSubsetOf_needs_several_segments){
+	PSET set({PSegment(0,100)});
+	EXPECT_TRUE(set.isSubsetOf(PSET({PSegment(50,100),PSegment(0,60)})));
+	EXPECT_FALSE(set.isSubsetOf(PSET({PSegment(51,100),PSegment(0,49)})));
+	EXPECT_TRUE(PSET().isSubsetOf(set));
+	EXPECT_FALSE(set.isSubsetOf(PSET()));
+	EXPECT_FALSE(set.intersects(PSET({PSegment(101,200)})));
+}
 RC_GTEST_PROP(SegmentSet,INTERSECTION_NEGATED_par_vs_seq,(const PSET& set1, const PSET& set2)){
 	auto cpy1 = set1;
 	auto cpy2 = set1;
@@ -192,6 +294,46 @@ RC_GTEST_PROP(SegmentSet,compacted_sets_are_equal_to_uncompacted,(const PSET& se
 	cpy.compact();
 	RC_ASSERT(cpy == set);
 }
+RC_GTEST_PROP(SegmentSet,compacted_indexed_sets_are_equal_to_uncompacted,(const PSET& set)){
+	auto cpy = set;
+	cpy.buildIndex();
+	cpy.compact();
+	RC_ASSERT(cpy == set);
+}
+TEST(SegmentSet,compact_drops_the_index){
+	//sorting the segments without merging them keeps their number, the ids of the index are stale anyway
+	PSET set({PSegment(100,200),PSegment(10,20)});
+	auto expected = set;
+	set.buildIndex();
+	set.compact();
+	EXPECT_FALSE(set.hasIndex());
+	EXPECT_EQ(set.segments.size(),2);
+	EXPECT_EQ(set,expected);
+}
+RC_GTEST_PROP(SegmentSet,compacted_sets_have_no_mergeable_segments,(const PSET& set)){
+	auto cpy = set;
+	cpy.compact();
+	for(size_t i = 0; i < cpy.segments.size(); ++i){
+		for(size_t j = i+1; j < cpy.segments.size(); ++j){
+			RC_ASSERT(!cpy.segments[i].mergeable(cpy.segments[j]));
+		}
+	}
+}
+RC_GTEST_PROP(SegmentSet,compact_with_budget_is_equal_to_uncompacted,(const PSET& set)){
+	auto cpy = set;
+	cpy.compact({.max_passes = 1});
+	RC_ASSERT(cpy.segments.size() <= set.segments.size());
+	RC_ASSERT(cpy == set);
+	auto untouched = set;
+	untouched.compact({.max_passes = 0});
+	RC_ASSERT(untouched.segments.size() == set.segments.size());
+}
+TEST(SegmentSet,compact_merges_touching_segments){
+	PSET set({PSegment(0,4,0,9),PSegment(5,9,0,4),PSegment(5,9,5,9),PSegment(20,30)});
+	set.compact();
+	EXPECT_EQ(set.segments.size(),2);
+	EXPECT_EQ(set.segments[0],PSegment(0,9,0,9));
+}
 RC_GTEST_PROP(SegmentSet,single_segment_set_has_same_value_as_segment,(const PSegment& seg)){
 	PSET set(std::vector<PSegment>{seg});
 	RC_ASSERT(set.getAmountPointsExakt() == seg.getAmountPointsExakt());
@@ -265,6 +407,67 @@ RC_GTEST_PROP(SegmentSet,intersection_of_negative_is_empty,(const PSET& set)){
 	cpy.INTERSECTION_NEGATED(set);
 	RC_ASSERT(cpy.isEmpty());
 }
+RC_GTEST_PROP(SegmentSet,NEGATE_cells_vs_seq,(const PSET& set)){
+	auto cpy1 = set;
+	auto cpy2 = set;
+	cpy1.NEGATE_cells();
+	cpy2.NEGATE_seq();
+	RC_ASSERT(cpy1 == cpy2);
+	for(size_t i = 0; i < cpy1.segments.size(); ++i){
+		for(size_t j = i+1; j < cpy1.segments.size(); ++j){
+			RC_ASSERT(intersect(cpy1.segments[i],cpy1.segments[j]).empty());
+		}
+	}
+}
+TEST(SegmentSet,NEGATE_cells_merges_cells){
+	PSegment s1(20,200);
+	PSegment s2(0,max_val,30,300);
+	PSET set({s1,s2});
+	set.NEGATE_cells();
+	EXPECT_EQ(set.segments.size(),4);
+	PSET empty;
+	empty.NEGATE_cells();
+	EXPECT_EQ(empty.segments.size(),1);
+	empty.NEGATE_cells();
+	EXPECT_TRUE(empty.isEmpty());
+}
+RC_GTEST_PROP(SegmentSet,canonicalize_keeps_points,(const PSET& set)){
+	auto cpy = set;
+	cpy.canonicalize();
+	RC_ASSERT(cpy.isCanonical());
+	RC_ASSERT(cpy == set);
+	RC_ASSERT(std::is_sorted(cpy.segments.begin(),cpy.segments.end()));
+	for(size_t i = 0; i < cpy.segments.size(); ++i){
+		for(size_t j = i+1; j < cpy.segments.size(); ++j){
+			RC_ASSERT(intersect(cpy.segments[i],cpy.segments[j]).empty());
+			RC_ASSERT(!cpy.segments[i].mergeable(cpy.segments[j]));
+		}
+	}
+	auto inclusion_exclusion = set;
+	RC_ASSERT(cpy.getAmountPointsExaktSafe() == inclusion_exclusion.getAmountPointsExaktSafe());
+}
+RC_GTEST_PROP(SegmentSet,canonicalize_is_unique,(const PSET& set1, const PSET& set2)){
+	//set1 and set1 united with a part of itself contain the same points
+	auto cpy1 = set1;
+	auto cpy2 = UNION(set1,INTERSECTION(set1,set2));
+	cpy1.canonicalize();
+	cpy2.canonicalize();
+	RC_ASSERT(std::ranges::equal(cpy1.segments,cpy2.segments));
+	RC_ASSERT(cpy1.hash() == cpy2.hash());
+	auto negated_twice = set1;
+	negated_twice.NEGATE_cells();
+	negated_twice.NEGATE_cells();
+	RC_ASSERT(std::ranges::equal(cpy1.segments,negated_twice.segments));
+}
+TEST(SegmentSet,canonical_flag_is_dropped_on_modification){
+	PSET set({PSegment(0,10),PSegment(5,20)});
+	set.canonicalize();
+	EXPECT_TRUE(set.isCanonical());
+	EXPECT_EQ(set.segments.size(),1);
+	EXPECT_EQ(set.segments[0],PSegment(0,20));
+	set.UNION(PSET({PSegment(30,40)}));
+	EXPECT_FALSE(set.isCanonical());
+}
 RC_GTEST_PROP(SegmentSet,double_negation,(const PSET& set)){
 	auto temp = set;
 	temp.NEGATE();
@@ -3,6 +3,7 @@
 #include <argparse/argparse.hpp>
 #include <filesystem>
 #include "log.hpp"
+#include "spill.hpp"
 #include <omp.h>
 namespace args{
 	void parse(int argc, char** argv){
@@ -15,6 +16,9 @@ namespace args{
 		constexpr auto CONFIG_ARG = "--config";
 		constexpr auto THREADS_ARG = "--threads";
 		constexpr auto NFT_ARG = "--nft";
+		constexpr auto MEMORY_LIMIT_ARG = "--memory-limit";
+		constexpr auto ENGINE_ARG = "--engine";
+		constexpr auto SNAPSHOT_ARG = "--snapshot";
 		argparser.add_argument(NFT_ARG)
 			.default_value(false)
 			.implicit_value(true)
@@ -32,14 +36,27 @@ namespace args{
 			.help("shows progress output");
 		argparser.add_argument("-t",THREADS_ARG)
 			.default_value("1")
-			.help("how many cores can be used to calculate");
+			.help("how many cores can be used to parse tables, analyze several ruleset files and by the subset, mergeable and consumer analysis, several files split the cores between them");
+		argparser.add_argument("-m",MEMORY_LIMIT_ARG)
+			.default_value("0")
+			.help("MB of packet sets kept in RAM, larger sets are moved to temporary files in $TMPDIR (0 = unlimited)");
+		argparser.add_argument("-e",ENGINE_ARG)
+			.default_value(std::string{"segments"})
+			.help("representation of packet sets during the dead rule analysis: segments, compressed, bdd or classes");
 		argparser.add_argument(CONFIG_ARG)
 			.default_value(std::string{""})
 			.help("specify path of the config file");
 		argparser.add_argument(RULESET_ARG)
-			.help("specifys the iptables-save dump path, which contains all rules");
+			.nargs(argparse::nargs_pattern::at_least_one)
+			.help("specifys the iptables-save dump paths, each is analyzed on its own");
 		argparser.add_argument(IPSET_ARG)
-			.help("specifys the ipset path, which contains ipset configuration");
+			.default_value(std::vector<std::string>{})
+			.append()
+			.help("specifys the ipset path, which contains ipset configuration, once for all or once per ruleset");
+		argparser.add_argument(SNAPSHOT_ARG)
+			.default_value(std::vector<std::string>{})
+			.append()
+			.help("specifys a snapshot path per ruleset, which is loaded instead of parsing the ruleset or written after parsing it");
 
 		try {
 			argparser.parse_args(argc, argv);
@@ -52,8 +69,18 @@ namespace args{
 #define PRESENT(var,arg_name) var = argparser.present<decltype(var)::value_type>(arg_name)
 #define GET(var,arg_name) var = argparser.get<decltype(var)>(arg_name)
 #define USED(var,arg_name) var = argparser.is_used(arg_name)
-		PRESENT(ruleset_filename,RULESET_ARG);
-		PRESENT(ipset_filename,IPSET_ARG);
+		if(!argparser.is_used(RULESET_ARG)){
+			mlog::fatal("expects at least one {} file\n",RULESET_ARG);
+		}
+		GET(ruleset_filenames,RULESET_ARG);
+		GET(ipset_filenames,IPSET_ARG);
+		if(ipset_filenames.size() > 1 && ipset_filenames.size() != ruleset_filenames.size()){
+			mlog::fatal("{} expects a single file or one file per ruleset\n",IPSET_ARG);
+		}
+		GET(snapshot_filenames,SNAPSHOT_ARG);
+		if(!snapshot_filenames.empty() && snapshot_filenames.size() != ruleset_filenames.size()){
+			mlog::fatal("{} expects one file per ruleset\n",SNAPSHOT_ARG);
+		}
 		GET(verbose,VERBOSE_ARG);
 		GET(nft,NFT_ARG);
 		GET(progress,PROGRESS_ARG);
@@ -70,7 +97,31 @@ namespace args{
 				config.print();
 			}
 		}
-		/* threads = stoi(argparser.get<std::string>(THREADS_ARG)); */
+		try{
+			threads = std::stoi(argparser.get<std::string>(THREADS_ARG));
+		}catch(const std::logic_error&){
+			threads = 0;
+		}
+		if(threads < 1){
+			mlog::fatal("{} expects a positive number\n",THREADS_ARG);
+		}
+		try{
+			memory_limit_mb = std::stoull(argparser.get<std::string>(MEMORY_LIMIT_ARG));
+		}catch(const std::logic_error&){
+			mlog::fatal("{} expects a number of MB\n",MEMORY_LIMIT_ARG);
+		}
+		spill::setBudget(memory_limit_mb*1024*1024);
+		if(auto name = argparser.get<std::string>(ENGINE_ARG); name == "segments"){
+			engine = Engine::SEGMENTS;
+		}else if(name == "bdd"){
+			engine = Engine::BDD;
+		}else if(name == "classes"){
+			engine = Engine::CLASSES;
+		}else if(name == "compressed"){
+			engine = Engine::COMPRESSED;
+		}else{
+			mlog::fatal("{} expects segments, compressed, bdd or classes\n",ENGINE_ARG);
+		}
 		/* omp_set_num_threads(threads); */
 		/* mlog::info("setting {} threads\n",threads); */
 #undef PRESENT
@@ -1,18 +1,43 @@
 #pragma once
 #include <optional>
 #include <string>
+#include <vector>
 #include "config.hpp"
+#include <algorithm>
+#include <omp.h>
 
 namespace args {
-	inline std::optional<std::string> ruleset_filename;
-	inline std::optional<std::string> ipset_filename;
+	//!representation of the packet sets piped through the ruleset
+	enum class Engine {
+		SEGMENTS,///<PSET
+		BDD,///<PacketBDD
+		CLASSES,///<PacketClasses, falls back to BDD if there are too many classes
+		COMPRESSED///<CSET, falls back to SEGMENTS if there are too many interval boundaries
+	};
+	inline std::vector<std::string> ruleset_filenames;
+	//!either empty, a single file for all rulesets or one file per ruleset
+	inline std::vector<std::string> ipset_filenames;
+	//!either empty or one snapshot file per ruleset
+	inline std::vector<std::string> snapshot_filenames;
 	inline bool verbose;
 	inline bool progress;
 	inline bool nft;
 	inline bool analyze_consumers;
 	inline int threads;
+	inline size_t memory_limit_mb;
+	inline Engine engine = Engine::SEGMENTS;
 	inline config_t config;
 
+	/**
+	 * @returns the amount of threads a parallel region may use\n
+	 * inside an enclosing parallel region the threads are split between its members
+	 */
+	inline int regionThreads(){
+		const int team = omp_get_num_threads();
+		const int total = std::max(threads,1);
+		return std::max(total/team + (omp_get_thread_num() < total%team),1);
+	}
+
 
 	/**
 	 * calls the argument parser\n
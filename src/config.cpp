@@ -1,9 +1,11 @@
 #include "config.hpp"
 #include "util.hpp"
+#include "log.hpp"
 
 #include <ryml.hpp>
 #include <iostream>
 #include <fstream>
+#include <charconv>
 
 auto loadFile(const std::string& name) -> std::string {
 	std::ifstream file(name);
@@ -12,6 +14,23 @@ auto loadFile(const std::string& name) -> std::string {
 auto toSV(c4::csubstr sub) -> std::string_view {
 	return  {sub.str,sub.len};
 }
+template<typename T>
+auto toNumber(c4::csubstr sub) -> T {
+	T ret{};
+	auto [ptr,ec] = std::from_chars(sub.str,sub.str+sub.len,ret);
+	if(ec != std::errc() || ptr != sub.str+sub.len){
+		mlog::fatal("expected a number in config but got '{}'\n",toSV(sub));
+	}
+	return ret;
+}
+//!accepts the yaml booleans and 0 or 1
+auto toBool(c4::csubstr sub) -> bool {
+	auto value = toSV(sub);
+	if(value == "true" || value == "True" || value == "TRUE" || value == "1")return true;
+	if(value == "false" || value == "False" || value == "FALSE" || value == "0")return false;
+	mlog::fatal("expected true or false in config but got '{}'\n",value);
+	return false;
+}
 config_t::config_t(const std::string& filename) :
 	file(loadFile(filename))
 {
@@ -58,6 +77,39 @@ config_t::config_t(const std::string& filename) :
 			}
 		}
 	}
+	if(tree.rootref().has_child("compaction")){
+		auto node = tree["compaction"];
+		if(node.has_child("growth_ratio")){
+			compaction.growth_ratio = toNumber<double>(node["growth_ratio"].val());
+		}
+		if(node.has_child("min_segments")){
+			compaction.min_segments = toNumber<size_t>(node["min_segments"].val());
+		}
+		if(node.has_child("max_passes")){
+			compaction.max_passes = toNumber<size_t>(node["max_passes"].val());
+		}
+		if(node.has_child("max_time_ms")){
+			compaction.max_time_ms = toNumber<size_t>(node["max_time_ms"].val());
+		}
+	}
+	if(tree.rootref().has_child("pipe_cache")){
+		auto node = tree["pipe_cache"];
+		if(node.has_child("enabled")){
+			pipe_cache.enabled = toBool(node["enabled"].val());
+		}
+		if(node.has_child("max_memory_mb")){
+			pipe_cache.max_memory_mb = toNumber<size_t>(node["max_memory_mb"].val());
+		}
+		if(node.has_child("max_input_segments")){
+			pipe_cache.max_input_segments = toNumber<size_t>(node["max_input_segments"].val());
+		}
+	}
+	if(tree.rootref().has_child("canonicalize")){
+		auto node = tree["canonicalize"];
+		if(node.has_child("max_segments")){
+			canonicalize.max_segments = toNumber<size_t>(node["max_segments"].val());
+		}
+	}
 	if(tree.rootref().has_child("check_chains")){
 		for(const auto& elem : tree["check_chains"]){
 			check_chains.insert(toSV(elem.val()));
@@ -44,6 +44,51 @@ struct config_t {
 			std::map<std::string_view,std::optional<std::string_view>> with_flags;
 		} rules;
 	} disable;
+	struct compaction_t {
+		/**
+		 * the packets piped through a chain are compacted\n
+		 * once their amount of segments grew by this factor\n
+		 * since the last compaction
+		 * @sa CompactionPolicy
+		 */
+		double growth_ratio = 4;
+		/**
+		 * sets with less segments are never compacted
+		 */
+		size_t min_segments = 1024;
+		/**
+		 * limits of a single compaction
+		 * @sa SegmentSet::compact_budget
+		 */
+		size_t max_passes = 2;
+		size_t max_time_ms = 1000;
+	} compaction;
+	struct pipe_cache_t {
+		/**
+		 * results of piping packets through a chain are reused\n
+		 * when the same packets are piped through the chain again
+		 * @sa IpAnalyzer::pipeChain
+		 */
+		bool enabled = true;
+		/**
+		 * no results are added once the stored results of a single run exceed this amount of memory\n
+		 * the stored ones are still reused
+		 */
+		size_t max_memory_mb = 512;
+		/**
+		 * inputs with more segments are not cached\n
+		 * because canonicalizing them costs more than piping them again
+		 */
+		size_t max_input_segments = 1024;
+	} pipe_cache;
+	struct canonicalize_t {
+		/**
+		 * maximumMatchingSets with at most this many segments are canonicalized before the analysis\n
+		 * 0 disables it, canonicalizing costs O(n^2*c) and can produce more segments than before
+		 * @sa SegmentSet::canonicalize
+		 */
+		size_t max_segments = 0;
+	} canonicalize;
 	std::set<std::string_view> interfaces;
 	std::set<std::string_view> check_chains;
 
@@ -28,6 +28,56 @@ static void BM_seq_INTERSECTION(benchmark::State& state){
 	}
 	benchmark::DoNotOptimize(test_set);
 }
+static void BM_sweep_INTERSECTION(benchmark::State& state){
+	for(auto _ : state){
+		auto result = test_set;
+		result.INTERSECTION_sweep(test_set);
+		benchmark::DoNotOptimize(result);
+	}
+	benchmark::DoNotOptimize(test_set);
+}
+//test_set is too small to show the per instruction throughput of the kernels
+static PSET generate_overlap_set(){
+	rc::Random r(0);
+	auto generator = rc::gen::container<std::vector<PSegment>>(2048,rc::gen::arbitrary<PSegment>());
+	return PSET(bor::vector<PSegment>(generator(r,100).value()));
+}
+static PSET overlap_set = generate_overlap_set();
+//counts for every segment of overlap_set the segments of overlap_set overlapping with it
+template<simd::level level>
+static void BM_overlap_columns(benchmark::State& state){
+	if(!simd::supported(level)){
+		state.SkipWithError("kernel not supported by this cpu");
+		return;
+	}
+	SegmentColumns<PSegment> columns(overlap_set.segments);
+	for(auto _ : state){
+		size_t overlaps = 0;
+		for(const auto& seg : overlap_set.segments){
+			for(size_t i = columns.nextOverlap(seg,0,level); i < columns.size(); i = columns.nextOverlap(seg,i+1,level)){
+				overlaps++;
+			}
+		}
+		benchmark::DoNotOptimize(overlaps);
+	}
+}
+//the loop SegmentColumns replaces in INTERSECTION_NEGATED_seq
+static void BM_overlap_intersect(benchmark::State& state){
+	for(auto _ : state){
+		size_t overlaps = 0;
+		for(const auto& seg1 : overlap_set.segments){
+			for(const auto& seg2 : overlap_set.segments){
+				if(!intersect(seg1,seg2).empty())overlaps++;
+			}
+		}
+		benchmark::DoNotOptimize(overlaps);
+	}
+}
+BENCHMARK(BM_overlap_intersect);
+BENCHMARK_TEMPLATE(BM_overlap_columns,simd::level::scalar);
+BENCHMARK_TEMPLATE(BM_overlap_columns,simd::level::sse4);
+BENCHMARK_TEMPLATE(BM_overlap_columns,simd::level::avx2);
 BENCHMARK(BM_seq_INTERSECTION);
+BENCHMARK(BM_sweep_INTERSECTION);
 BENCHMARK(BM_par_INTERSECTION)->DenseRange(1,8);
 BENCHMARK_MAIN();
@@ -21,6 +21,10 @@ namespace mlog{
 	void popPrefix(){
 		prefixes.pop_back();
 	}
+	std::recursive_mutex& outputMutex(){
+		static std::recursive_mutex mutex;
+		return mutex;
+	}
 	Level getLevel(){
 		return level;
 	}
@@ -2,6 +2,7 @@
 #include <string_view>
 #include <fmt/core.h>
 #include <functional>
+#include <mutex>
 
 namespace mlog {
 	enum class Level {
@@ -16,6 +17,8 @@ namespace mlog {
 	auto getLevel() -> Level;
 	void printPostfix();
 	void printPrefix();
+	//!serializes the output of concurrent threads, level and prefix changes are still global
+	auto outputMutex() -> std::recursive_mutex&;
 
 	template<typename ... Args>
 	void print(std::string_view format_string, Args...args){
@@ -23,12 +26,14 @@ namespace mlog {
 	}
 	template<typename ... Args>
 	void log(std::string_view format_string, Args...args){
+		std::lock_guard lock(outputMutex());
 		printPrefix();
 		fmt::print(fmt::runtime(format_string),args...);
 		printPostfix();
 	}
 	template<Level level, typename ... Args>
 	void restoreLevel(std::string_view format_string, Args...args){
+		std::lock_guard lock(outputMutex());
 		auto prev = getLevel();
 		setLevel(level);
 		log(format_string,args...);
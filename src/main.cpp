@@ -3,35 +3,86 @@
 #include "IpAnalyzer.hpp"
 #include <argparse/argparse.hpp>
 #include "args.hpp"
+#include "snapshot.hpp"
 #include <chrono>
+#include <memory>
+#include <algorithm>
+#include <optional>
+#include <sstream>
+#include <omp.h>
 
 
 int main(int argc, char** argv){
 	auto t_start = std::chrono::high_resolution_clock::now();
 	args::parse(argc,argv);
 
+	const auto& files = args::ruleset_filenames;
+	std::vector<std::unique_ptr<RulesetParser>> parsers(files.size());
+	std::vector<std::unique_ptr<IpAnalyzer>> analyzers(files.size());
 
-	RulesetParser parser;
-	if(args::ipset_filename){
-		parser.parseIpSets(*args::ipset_filename);
-	}
-	if(args::nft){
-		parser.parseRuleset_NFT(*args::ruleset_filename);
-	}else{
-		parser.parseRuleset(*args::ruleset_filename);
-	}
+	//every ruleset is analyzed on its own, the threads are distributed among them
+	//and the parallel regions of each analysis use its share of args::regionThreads
+	//the progress output uses the global prefixes of mlog, so it needs one ruleset at a time
+	const int file_threads = std::min<int>(std::max(args::threads,1),files.size());
+	omp_set_max_active_levels(2);
+#pragma omp parallel for schedule(dynamic,1) num_threads(file_threads) if(!args::progress)
+	for(size_t i = 0; i < files.size(); ++i){
+		auto& parser = parsers[i];
+		parser = std::make_unique<RulesetParser>();
+		std::vector<std::string> sources = {files[i]};
+		if(!args::ipset_filenames.empty()){
+			sources.push_back(args::ipset_filenames[std::min(i,args::ipset_filenames.size()-1)]);
+		}
+		//a snapshot is only valid for the dumps it was parsed from
+		const bool use_snapshot = !args::snapshot_filenames.empty();
+		//pipes have been read by the checksum already, so they are parsed from their text
+		std::vector<std::optional<std::string>> texts(sources.size());
+		const uint64_t checksum = use_snapshot ? snapshot::checksum(sources,&texts) : 0;
+		const bool loaded = use_snapshot && snapshot::load(args::snapshot_filenames[i],checksum,parser->ruleset,parser->results);
+		if(!loaded){
+			if(sources.size() > 1){
+				if(texts[1]){
+					std::istringstream in(*texts[1]);
+					parser->parseIpSets(in);
+				}else{
+					parser->parseIpSets(sources[1]);
+				}
+			}
+			if(texts[0]){
+				std::istringstream in(*texts[0]);
+				if(args::nft){
+					parser->parseRuleset_NFT(in);
+				}else{
+					parser->parseRuleset(in);
+				}
+			}else if(args::nft){
+				parser->parseRuleset_NFT(files[i]);
+			}else{
+				parser->parseRuleset(files[i]);
+			}
+		}
 
-	IpAnalyzer analyzer(parser.releaseRuleset());
-	auto& parse_results = parser.getInfo();
+		auto& analyzer = analyzers[i];
+		analyzer = std::make_unique<IpAnalyzer>(parser->releaseRuleset());
+		if(use_snapshot && !loaded){
+			snapshot::write(args::snapshot_filenames[i],checksum,analyzer->ruleset(),parser->getInfo());
+		}
+
+		analyzer->checkGraph();
+		analyzer->analyzeDeadRules();
+		if(args::analyze_consumers){
+			analyzer->findDeadRuleConsumers();
+		}
+		analyzer->findSubsetRules();
+		analyzer->findMergeableRules();
+	}
 
-	analyzer.checkGraph();
-	analyzer.analyzeDeadRules();
-	if(args::analyze_consumers){
-		analyzer.findDeadRuleConsumers();
+	for(size_t i = 0; i < files.size(); ++i){
+		if(files.size() > 1){
+			mlog::info("ruleset file \"{}\"\n",files[i]);
+		}
+		analyzers[i]->printSummary(parsers[i]->getInfo());
 	}
-	analyzer.findSubsetRules();
-	analyzer.findMergeableRules();
-	analyzer.printSummary(parse_results);
 
 
 	auto t_end = std::chrono::high_resolution_clock::now();
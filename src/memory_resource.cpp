@@ -0,0 +1,135 @@
+#include "memory_resource.hpp"
+#include "spill.hpp"
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <numeric>
+
+namespace bor {
+	static std::atomic<size_t> heap_allocations = 0;
+	static std::atomic<size_t> arena_allocations = 0;
+	static std::atomic<size_t> arena_chunks = 0;
+	static std::atomic<size_t> shared_copies = 0;
+	static std::atomic<size_t> element_copies = 0;
+	static std::atomic<size_t> detached_copies = 0;
+
+	void* memory_resource::reallocate(void* ptr, size_t old_bytes, size_t new_bytes, size_t align){
+		void* ret = allocate(new_bytes,align);
+		memcpy(ret,ptr,std::min(old_bytes,new_bytes));
+		deallocate(ptr,old_bytes);
+		return ret;
+	}
+
+	class spill_resource : public memory_resource {
+	public:
+		void* allocate(size_t bytes, size_t align) override {
+			//malloc and mmap both align to at least max_align_t
+			assert(align <= alignof(std::max_align_t));
+			heap_allocations.fetch_add(1,std::memory_order_relaxed);
+			return spill::allocate(bytes);
+		}
+		void deallocate(void* ptr, size_t bytes) override {
+			spill::deallocate(ptr,bytes);
+		}
+		void* reallocate(void* ptr, size_t old_bytes, size_t new_bytes, size_t align) override {
+			assert(align <= alignof(std::max_align_t));
+			heap_allocations.fetch_add(1,std::memory_order_relaxed);
+			return spill::reallocate(ptr,old_bytes,new_bytes);
+		}
+	};
+
+	memory_resource& heap_resource(){
+		static spill_resource resource;
+		return resource;
+	}
+	static thread_local memory_resource* default_m = nullptr;
+	memory_resource& default_resource(){
+		if(default_m == nullptr)return heap_resource();
+		return *default_m;
+	}
+
+	resource_scope::resource_scope(memory_resource& resource) : prev_m(default_m){
+		default_m = &resource;
+	}
+	resource_scope::~resource_scope(){
+		default_m = prev_m;
+	}
+
+	arena::arena(size_t initial_bytes) : initial_bytes_m(initial_bytes) {}
+	arena::~arena(){
+		freeChunks();
+	}
+	void* arena::allocate(size_t bytes, size_t align){
+		auto aligned = [&](){
+			auto addr = reinterpret_cast<uintptr_t>(top_m);
+			return reinterpret_cast<char*>((addr+align-1) & ~(align-1));
+		};
+		char* ptr = aligned();
+		if(top_m == nullptr || ptr > end_m || bytes > static_cast<size_t>(end_m-ptr)){
+			addChunk(bytes+align);
+			ptr = aligned();
+		}
+		top_m = ptr+bytes;
+		arena_allocations.fetch_add(1,std::memory_order_relaxed);
+		return ptr;
+	}
+	void arena::deallocate(void* ptr, size_t bytes){
+		//a vector that grows releases its previous storage right after the new one was taken,
+		//so only storage released in reverse order is reused before the next reset
+		if(static_cast<char*>(ptr)+bytes == top_m){
+			top_m = static_cast<char*>(ptr);
+		}
+	}
+	void* arena::reallocate(void* ptr, size_t old_bytes, size_t new_bytes, size_t align){
+		char* begin = static_cast<char*>(ptr);
+		if(begin+old_bytes == top_m && new_bytes <= static_cast<size_t>(end_m-begin)){
+			top_m = begin+new_bytes;
+			arena_allocations.fetch_add(1,std::memory_order_relaxed);
+			return ptr;
+		}
+		return memory_resource::reallocate(ptr,old_bytes,new_bytes,align);
+	}
+	void arena::reset(){
+		if(chunks_m.size() > 1){
+			size_t total = capacity();
+			freeChunks();
+			addChunk(total);
+			return;
+		}
+		if(!chunks_m.empty())top_m = chunks_m.front().data;
+	}
+	size_t arena::capacity() const {
+		return std::accumulate(chunks_m.begin(),chunks_m.end(),size_t{0},[](size_t sum, const chunk_t& chunk){
+					return sum+chunk.size;
+				});
+	}
+	void arena::addChunk(size_t min_bytes){
+		size_t size = chunks_m.empty() ? initial_bytes_m : chunks_m.back().size*2;
+		size = std::max(size,min_bytes);
+		char* data = static_cast<char*>(heap_resource().allocate(size,alignof(std::max_align_t)));
+		chunks_m.push_back({data,size});
+		top_m = data;
+		end_m = data+size;
+		arena_chunks.fetch_add(1,std::memory_order_relaxed);
+	}
+	void arena::freeChunks(){
+		for(const auto& chunk : chunks_m){
+			heap_resource().deallocate(chunk.data,chunk.size);
+		}
+		chunks_m.clear();
+		top_m = nullptr;
+		end_m = nullptr;
+	}
+
+	void countCopy(bool shared){
+		(shared ? shared_copies : element_copies).fetch_add(1,std::memory_order_relaxed);
+	}
+	void countDetach(){
+		detached_copies.fetch_add(1,std::memory_order_relaxed);
+	}
+	allocation_stats_t allocationStats(){
+		return {heap_allocations,arena_allocations,arena_chunks,shared_copies,element_copies,detached_copies};
+	}
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+namespace bor {
+	/**
+	 * @brief source of the storage of bor::vector
+	 * @details a vector keeps the resource it was constructed with,\n
+	 * default constructed and copied vectors use default_resource()
+	 */
+	class memory_resource {
+	public:
+		virtual ~memory_resource() = default;
+		/**
+		 * @throws std::bad_alloc if the storage can't be provided
+		 */
+		virtual auto allocate(size_t bytes, size_t align) -> void* = 0;
+		virtual void deallocate(void* ptr, size_t bytes) = 0;
+		/**
+		 * moves an allocation into storage for new_bytes, the contents are copied bytewise\n
+		 * by default a new allocation is copied into
+		 * @throws std::bad_alloc if the storage can't be provided, ptr stays valid then
+		 */
+		virtual auto reallocate(void* ptr, size_t old_bytes, size_t new_bytes, size_t align) -> void*;
+	};
+
+	//!@returns the resource taking storage from spill::allocate
+	auto heap_resource() -> memory_resource&;
+	//!@returns the resource new vectors of the calling thread are allocated from
+	auto default_resource() -> memory_resource&;
+
+	/**
+	 * @brief replaces the default_resource() of the calling thread during its lifetime
+	 */
+	class resource_scope {
+	public:
+		explicit resource_scope(memory_resource& resource);
+		~resource_scope();
+		resource_scope(const resource_scope&) = delete;
+		resource_scope& operator=(const resource_scope&) = delete;
+	private:
+		memory_resource* prev_m;
+	};
+
+	/**
+	 * @brief bump allocator for short lived vectors
+	 * @details allocations are carved out of chunks taken from heap_resource()\n
+	 * deallocate only gives back the most recent allocation, everything else\n
+	 * is freed at once by reset()\n
+	 * reset() merges the chunks into one, so an arena that is reset\n
+	 * repeatedly for similar work stops allocating from the heap\n
+	 * an arena must only be used by a single thread
+	 */
+	class arena : public memory_resource {
+	public:
+		explicit arena(size_t initial_bytes = 64*1024);
+		~arena() override;
+		arena(const arena&) = delete;
+		arena& operator=(const arena&) = delete;
+
+		auto allocate(size_t bytes, size_t align) -> void* override;
+		void deallocate(void* ptr, size_t bytes) override;
+		//!the most recent allocation is resized in place
+		auto reallocate(void* ptr, size_t old_bytes, size_t new_bytes, size_t align) -> void* override;
+		//!invalidates all storage handed out by this arena
+		void reset();
+		//!@returns bytes held in chunks
+		auto capacity() const -> size_t;
+	private:
+		void addChunk(size_t min_bytes);
+		void freeChunks();
+
+		struct chunk_t {
+			char* data;
+			size_t size;
+		};
+		std::vector<chunk_t> chunks_m;
+		char* top_m = nullptr;///< next free byte of the last chunk
+		char* end_m = nullptr;///< end of the last chunk
+		size_t initial_bytes_m;
+	};
+
+	struct allocation_stats_t {
+		size_t heap_allocations;///< calls to heap_resource().allocate, including arena chunks
+		size_t arena_allocations;
+		size_t arena_chunks;
+		size_t shared_copies;///< copies of vectors sharing the storage of the original
+		size_t element_copies;///< copies of vectors copying the elements right away
+		size_t detached_copies;///< shared storage copied because one of its vectors was modified
+	};
+	//!counts a copy of a vector for allocationStats()
+	void countCopy(bool shared);
+	//!counts shared storage copied by a vector that was modified
+	void countDetach();
+	//!@returns the allocations performed by all threads since the start of the program
+	auto allocationStats() -> allocation_stats_t;
+}
@@ -28,6 +28,15 @@ static void BM_seq_NEGATED(benchmark::State& state){
 	}
 	benchmark::DoNotOptimize(rhs);
 }
+static void BM_cells_NEGATED(benchmark::State& state){
+	for(auto _ : state){
+		auto result = rhs;
+		result.NEGATE_cells();
+		benchmark::DoNotOptimize(result);
+	}
+	benchmark::DoNotOptimize(rhs);
+}
 BENCHMARK(BM_seq_NEGATED);
+BENCHMARK(BM_cells_NEGATED);
 BENCHMARK(BM_par_NEGATED)->DenseRange(1,8);
 BENCHMARK_MAIN();
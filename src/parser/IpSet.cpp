@@ -4,35 +4,94 @@
 #include "common.hpp"
 
 #include <sstream>
-
-PSET IpSet_IP::toPSET(std::string_view src_dst_flags)  {
+#include <map>
+
+/**
+ * intersects the ip dimension of every segment in set with addresses\n
+ * segments that share their address range are intersected with the trie once
+ */
+template<int ip_index>
+static void intersectAddresses(PSET& set, const PrefixTrie& addresses){
+	std::map<std::pair<uint32_t,uint32_t>,std::vector<PrefixTrie::range_t>> intersections;
 	PSET ret;
+	for(const auto& seg : set.segments){
+		auto interval = seg.getInterval<ip_index>();
+		auto iter = intersections.find(interval);
+		if(iter == intersections.end()){
+			auto ranges = addresses.intersect(PrefixTrie(interval.first,interval.second)).ranges();
+			iter = intersections.emplace(interval,std::move(ranges)).first;
+		}
+		for(auto [start,end] : iter->second){
+			PSegment next = seg;
+			next.setInterval<ip_index>(start,end);
+			ret.segments.push_back(next);
+		}
+	}
+	set = std::move(ret);
+}
+
+void IpSet::apply(Rule& rule, PSET& ip_set, std::string_view src_dst_flags){
+	auto shared = match(src_dst_flags);
+	restrict(ip_set,*shared,src_dst_flags);
+	for(size_t flag = 0; flag < shared->flag_segments.size(); ++flag){
+		const auto& segments = shared->flag_segments[flag];
+		if(rule.flag_segments[flag].empty()){
+			//shares the set instead of copying it
+			rule.flag_segments[flag] = segments;
+		}else{
+			rule.flag_segments[flag].insert(std::begin(segments),std::end(segments));
+		}
+	}
+}
+auto IpSet::toPSET(std::string_view src_dst_flags) -> std::shared_ptr<const PSET> {
+	auto shared = match(src_dst_flags);
+	return std::shared_ptr<const PSET>(shared,&shared->set);
+}
+void IpSet::restrict(PSET& ip_set, const match_t& match, std::string_view){
+	//as long as a rule matches all packets, the intersection is a copy
+	if(ip_set.segments.size() == 1 && ip_set.segments[0] == PSegment{}){
+		ip_set = match.set;
+	}else{
+		ip_set.INTERSECTION(match.set);
+	}
+}
+auto IpSet::match(std::string_view src_dst_flags) -> std::shared_ptr<const match_t> {
+	std::lock_guard lock(cache_mutex);
+	auto iter = cache.find(src_dst_flags);
+	if(iter == cache.end()){
+		iter = cache.emplace(src_dst_flags,std::make_shared<const match_t>(build(src_dst_flags))).first;
+	}
+	return iter->second;
+}
+
+auto IpSet_IP::build(std::string_view src_dst_flags) -> match_t {
+	match_t ret;
 	auto [type] = util::unpack<1>(util::split(src_dst_flags,",").begin());
 	bool srcIP = type == "src";
-	for(auto [start_ip,end_ip] : ip_segments){
+	for(auto [start_ip,end_ip] : addresses.ranges()){
 		PSegment next;
 		if(srcIP){
 			next.setInterval<PSegment::SRC_IP_INDEX>(start_ip,end_ip);
+			ret.flag_segments[Rule::SRC_IP].emplace(start_ip,end_ip);
 		}else{
 			next.setInterval<PSegment::DST_IP_INDEX>(start_ip,end_ip);
+			ret.flag_segments[Rule::DST_IP].emplace(start_ip,end_ip);
 		}
-		ret.segments.push_back(next);
+		ret.set.segments.push_back(next);
 	}
 
 	return ret;
 }
 void IpSet_IP::add(RulesetParser&, std::string_view line)  {
 	auto [cmd,name,ip] = util::unpack<3>(util::split(line," ").begin());
-	ip_segments.emplace_back(parseIP(ip));
+	addresses.insert(parseIP(ip));
 }
-void IpSet_IP::apply(Rule& rule, PSET& ip_set, std::string_view src_dst_flags)  {
+void IpSet_IP::restrict(PSET& ip_set, const match_t&, std::string_view src_dst_flags)  {
 	auto [type] = util::unpack<1>(util::split(src_dst_flags,",").begin());
 	if( type == "src"){
-		ip_set.applyRange_helper<PSegment::SRC_IP_INDEX>(ip_segments,false);
-		rule.flag_segments[Rule::SRC_IP].insert(std::begin(ip_segments),std::end(ip_segments));
+		intersectAddresses<PSegment::SRC_IP_INDEX>(ip_set,addresses);
 	} else {
-		ip_set.applyRange_helper<PSegment::DST_IP_INDEX>(ip_segments,false);
-		rule.flag_segments[Rule::DST_IP].insert(std::begin(ip_segments),std::end(ip_segments));
+		intersectAddresses<PSegment::DST_IP_INDEX>(ip_set,addresses);
 	}
 }
 void IpSet_Iface::add(RulesetParser& parser, std::string_view line)  {
@@ -43,101 +102,46 @@ void IpSet_Iface::add(RulesetParser& parser, std::string_view line)  {
 	const auto out_id = parser.out_interfaces[std::string{iface}];
 	ip_interface_segments.emplace_back(ip_start,ip_end,in_id,out_id);
 }
-void IpSet_Iface::apply(Rule& rule, PSET& ip_set, std::string_view src_dst_flags)  {
-	auto [type_ip,type_iface] = util::unpack<2>(util::split(src_dst_flags,",").begin());
-	PSET set;
-	set.segments.clear();
-	bool srcIP = type_ip == "src";
-	bool srcInterface = type_iface == "src";
-	for(auto [start_ip,end_ip,in_interface_id,out_interface_id] : ip_interface_segments){
-		PSegment new_segment;
-		if(srcIP){
-			new_segment.setInterval<PSegment::SRC_IP_INDEX>(start_ip,end_ip);
-			rule.flag_segments[Rule::SRC_IP].emplace(start_ip,end_ip);
-		}else{
-			new_segment.setInterval<PSegment::DST_IP_INDEX>(start_ip,end_ip);
-			rule.flag_segments[Rule::DST_IP].emplace(start_ip,end_ip);
-		}
-		if(srcInterface){
-			new_segment.setInterval<PSegment::IN_INTERFACE_INDEX>(in_interface_id);
-			rule.flag_segments[Rule::IN_INTERFACE].emplace(in_interface_id,in_interface_id);
-		}else{
-			new_segment.setInterval<PSegment::OUT_INTERFACE_INDEX>(in_interface_id);
-			rule.flag_segments[Rule::OUT_INTERFACE].emplace(out_interface_id,out_interface_id);
-		}
-		set.segments.push_back(new_segment);
-	}
-	ip_set.INTERSECTION(set);
-}
-PSET IpSet_Iface::toPSET(std::string_view src_dst_flags)  {
+auto IpSet_Iface::build(std::string_view src_dst_flags) -> match_t {
 	auto [type_ip,type_iface] = util::unpack<2>(util::split(src_dst_flags,",").begin());
-	PSET set;
-	set.segments.clear();
+	match_t ret;
 	bool srcIP = type_ip == "src";
 	bool srcInterface = type_iface == "src";
 	for(auto [start_ip,end_ip,in_interface_id,out_interface_id] : ip_interface_segments){
 		PSegment new_segment;
 		if(srcIP){
 			new_segment.setInterval<PSegment::SRC_IP_INDEX>(start_ip, end_ip);
+			ret.flag_segments[Rule::SRC_IP].emplace(start_ip,end_ip);
 		}else{
 			new_segment.setInterval<PSegment::DST_IP_INDEX>(start_ip, end_ip);
+			ret.flag_segments[Rule::DST_IP].emplace(start_ip,end_ip);
 		}
 		if(srcInterface){
 			new_segment.setInterval<PSegment::IN_INTERFACE_INDEX>(in_interface_id);
+			ret.flag_segments[Rule::IN_INTERFACE].emplace(in_interface_id,in_interface_id);
 		}else{
 			new_segment.setInterval<PSegment::OUT_INTERFACE_INDEX>(out_interface_id);
+			ret.flag_segments[Rule::OUT_INTERFACE].emplace(out_interface_id,out_interface_id);
 		}
-		set.segments.push_back(new_segment);
+		ret.set.segments.push_back(new_segment);
 	}
-	return set;
+	return ret;
 }
 
-PSET IpSet_listset::toPSET(std::string_view src_dst_flags){
-	PSET result={{{}}};
+auto IpSet_listset::build(std::string_view src_dst_flags) -> match_t {
+	match_t ret;
+	ret.set = PSET{{{}}};
 	for(auto* set : sets){
-		result.UNION(set->toPSET(src_dst_flags));
+		ret.set.UNION(*set->toPSET(src_dst_flags));
 	}
-	return result;
-}
-void IpSet_listset::apply(Rule&,PSET& set, std::string_view src_dst_flags){
-	set.INTERSECTION(this->toPSET(src_dst_flags));
 	//TODO add flag segments
+	return ret;
 }
 void IpSet_listset::add(RulesetParser& parser, std::string_view line){
 	const auto [add,name,contained_set_name] = util::unpack<3>(util::split(line," ").begin());
 	sets.push_back(parser.ip_sets.get(std::string{contained_set_name}));
 }
 
-
-
-
-
-
-
-
-PSET IpSet_Port::toPSET(std::string_view src_dst_flags)  {
-	PSET ret;
-	auto [typeIP,typePort] = util::unpack<2>(util::split(src_dst_flags,",").begin());
-	bool srcIP = typeIP == "src";
-	bool srcPort = typePort == "src";
-	for(auto [start_ip,end_ip,start_port,end_port,protocol] : ip_port_protocol_segments){
-		PSegment next;
-		if(srcIP){
-			next.setInterval<PSegment::SRC_IP_INDEX>(start_ip,end_ip);
-		}else{
-			next.setInterval<PSegment::DST_IP_INDEX>(start_ip,end_ip);
-		}
-		if(srcPort){
-			next.setInterval<PSegment::SRC_PORT_INDEX>(start_port,end_port);
-		}else{
-			next.setInterval<PSegment::DST_PORT_INDEX>(start_port,end_port);
-		}
-		next.setInterval<PSegment::PROTOCOL_INDEX>(protocol,protocol);
-		ret.segments.push_back(next);
-	}
-
-	return ret;
-}
 void IpSet_Port::add(RulesetParser& parser, std::string_view line)  {
 	auto [cmd,name,ip_proto_port] = util::unpack<3>(util::split(line," ").begin());
 	auto [ip,proto_port] = util::unpack<2>(util::split(ip_proto_port,",").begin());
@@ -167,8 +171,8 @@ void IpSet_Port::add(RulesetParser& parser, std::string_view line)  {
 	auto [start_ip,end_ip] = parseIP(ip);
 	ip_port_protocol_segments.emplace_back(start_ip,end_ip,start_port,end_port,protocol);
 }
-void IpSet_Port::apply(Rule& rule, PSET& ip_set, std::string_view src_dst_flags)  {
-	PSET ret;
+auto IpSet_Port::build(std::string_view src_dst_flags) -> match_t {
+	match_t ret;
 	auto [typeIP,typePort] = util::unpack<2>(util::split(src_dst_flags,",").begin());
 	bool srcIP = typeIP == "src";
 	bool srcPort = typePort == "src";
@@ -176,22 +180,22 @@ void IpSet_Port::apply(Rule& rule, PSET& ip_set, std::string_view src_dst_flags)
 		PSegment next;
 		if(srcIP){
 			next.setInterval<PSegment::SRC_IP_INDEX>(start_ip,end_ip);
-			rule.flag_segments[Rule::SRC_IP].emplace(start_ip,end_ip);
+			ret.flag_segments[Rule::SRC_IP].emplace(start_ip,end_ip);
 		}else{
 			next.setInterval<PSegment::DST_IP_INDEX>(start_ip,end_ip);
-			rule.flag_segments[Rule::DST_IP].emplace(start_ip,end_ip);
+			ret.flag_segments[Rule::DST_IP].emplace(start_ip,end_ip);
 		}
 		if(srcPort){
 			next.setInterval<PSegment::SRC_PORT_INDEX>(start_port,end_port);
-			rule.flag_segments[Rule::SRC_PORT].emplace(start_ip,end_ip);
+			ret.flag_segments[Rule::SRC_PORT].emplace(start_ip,end_ip);
 		}else{
 			next.setInterval<PSegment::DST_PORT_INDEX>(start_port,end_port);
-			rule.flag_segments[Rule::DST_PORT].emplace(start_ip,end_ip);
+			ret.flag_segments[Rule::DST_PORT].emplace(start_ip,end_ip);
 		}
 		next.setInterval<PSegment::PROTOCOL_INDEX>(protocol,protocol);
-		rule.flag_segments[Rule::DST_PORT].emplace(protocol,protocol);
-		ret.segments.push_back(next);
+		ret.flag_segments[Rule::DST_PORT].emplace(protocol,protocol);
+		ret.set.segments.push_back(next);
 	}
 
-	ip_set.INTERSECTION(ret);
+	return ret;
 }
@@ -1,9 +1,15 @@
 #pragma once
 #include <vector>
 #include <unordered_map>
+#include <map>
+#include <set>
+#include <array>
+#include <memory>
+#include <mutex>
 
 #include "../Ruleset.hpp"
 #include "../SegmentSet.hpp"
+#include "../PrefixTrie.hpp"
 
 
 class RulesetParser;
@@ -17,48 +23,72 @@ public:
 	 */
 	virtual void add(RulesetParser& parser, std::string_view line) = 0;
 	/**
-	 * applys the constraint of this set to a rule that called match-set on it
+	 * applys the constraint of this set to a rule that called match-set on it\n
+	 * the packets and flag segments of the set are built once per src_dst_flags\n
+	 * and shared by all rules, so it may be called by concurrent threads after all entries were added
 	 * @param rule used to insert into Rule::flag_segments
 	 * @param ip_set will be constrained
 	 * @param string after the "match-set" and [set-name] which can only be a comma seperated list
 	 * of dst and src
 	 */
-	virtual void apply(Rule& rule, PSET& ip_set, std::string_view src_dst_flags) = 0;
+	void apply(Rule& rule, PSET& ip_set, std::string_view src_dst_flags);
 	/**
-	 * @return PSET that contains alle packages matched by only this set given the src_dst_flags parameter
+	 * @return PSET that contains alle packages matched by only this set given the src_dst_flags parameter\n
+	 * the same immutable PSET is returned for equal src_dst_flags
 	 */
-	virtual PSET toPSET(std::string_view src_dst_flags) = 0;
+	auto toPSET(std::string_view src_dst_flags) -> std::shared_ptr<const PSET>;
 	virtual ~IpSet() = default;
+protected:
+	//!what a match-set with the same src_dst_flags does to every rule
+	struct match_t {
+		PSET set;
+		Rule::flag_segments_t flag_segments = {};
+	};
+	//!builds the match_t of src_dst_flags, called once per src_dst_flags
+	virtual auto build(std::string_view src_dst_flags) -> match_t = 0;
+	//!intersects ip_set with match.set
+	virtual void restrict(PSET& ip_set, const match_t& match, std::string_view src_dst_flags);
+private:
+	auto match(std::string_view src_dst_flags) -> std::shared_ptr<const match_t>;
+
+	std::mutex cache_mutex;
+	std::map<std::string,std::shared_ptr<const match_t>,std::less<>> cache;
 };
+/**
+ * the addresses are kept in a PrefixTrie, so overlapping and adjacent entries\n
+ * are merged and a rule is restricted by as few ranges as possible
+ */
 class IpSet_IP : public IpSet{
 public:
 	void add(RulesetParser&, std::string_view line) override;
-	void apply(Rule& rule, PSET& ip_set, std::string_view src_dst_flags) override;
-	PSET toPSET(std::string_view src_dst_flags) override;
+protected:
+	auto build(std::string_view src_dst_flags) -> match_t override;
+	//!intersects the address ranges of ip_set with the trie instead of match.set
+	void restrict(PSET& ip_set, const match_t& match, std::string_view src_dst_flags) override;
 private:
-	std::vector<std::pair<uint32_t,uint32_t>> ip_segments;
+	PrefixTrie addresses;
 };
 class IpSet_listset : public IpSet {
 public:
 	void add(RulesetParser& parser, std::string_view line) override;
-	void apply(Rule& rule, PSET& ip_set, std::string_view src_dst_flags) override;
-	PSET toPSET(std::string_view src_dst_flags) override;
+protected:
+	auto build(std::string_view src_dst_flags) -> match_t override;
 private:
 	std::vector<IpSet*> sets;
 };
 class IpSet_Port : public IpSet {
 public:
 	void add(RulesetParser& parser, std::string_view line) override;
-	void apply(Rule& rule, PSET& ip_set, std::string_view src_dst_flags) override;
-	PSET toPSET(std::string_view src_dst_flags) override;
+protected:
+	auto build(std::string_view src_dst_flags) -> match_t override;
 private:
 	std::vector<std::tuple<uint32_t,uint32_t,uint16_t,uint16_t,uint8_t>> ip_port_protocol_segments;
 };
 class IpSet_Iface : public IpSet {
 public:
 	void add(RulesetParser& parser, std::string_view line) override;
-	void apply(Rule& rule, PSET& ip_set, std::string_view src_dst_flags) override;
-	PSET toPSET(std::string_view src_dst_flags) override;
+protected:
+	auto build(std::string_view src_dst_flags) -> match_t override;
 private:
 	std::vector<std::tuple<uint32_t,uint32_t,uint8_t,uint8_t>> ip_interface_segments;
 };
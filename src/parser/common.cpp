@@ -3,12 +3,56 @@
 
 #include <stdexcept>
 #include <istream>
-#include <sstream>
 #include <fmt/core.h>
 
 auto parseIP(std::string_view in, int line) -> std::pair<uint32_t,uint32_t> {
-	std::stringstream ss(std::string{in});
-	return parseIP(ss,line);
+	size_t pos = 0;
+	auto fail = [&](std::string_view expected){
+		throw std::runtime_error(fmt::format("invalid ip \"{}\" on line {}: expected {} at column {}",in,line,expected,pos+1));
+	};
+	auto isDigit = [&](){
+		return pos < in.size() && '0' <= in[pos] && in[pos] <= '9';
+	};
+	//reads a number up to max, more digits than max has are reported at the start of the number
+	auto number = [&](size_t max_digits, uint32_t max, std::string_view expected){
+		auto number_pos = pos;
+		uint32_t value = 0;
+		size_t digits = 0;
+		while(digits < max_digits && isDigit()){
+			value = value*10+static_cast<uint32_t>(in[pos]-'0');
+			++pos;
+			++digits;
+		}
+		if(digits == 0)fail("a digit");
+		if(value > max || isDigit()){
+			pos = number_pos;
+			fail(expected);
+		}
+		return value;
+	};
+
+	uint32_t start = 0;
+	constexpr auto bits_in_byte = 8;
+	for(auto i = 0; i < 4; ++i){
+		auto octet = number(3,255,"an octet up to 255");
+		start = start << bits_in_byte | octet;
+		if(i != 3){
+			if(pos == in.size() || in[pos] != '.')fail("'.'");
+			++pos;
+		}
+	}
+	//ports, ranges and ipset options may follow the address, another octet may not
+	if(pos < in.size() && in[pos] == '.')fail("'/' or the end of the address");
+	if(pos == in.size() || in[pos] != '/'){
+		return {start,start};
+	}
+	++pos;
+	auto prefix = number(2,32,"a prefix length up to 32");
+	uint32_t mask = (uint64_t{1} << (32-prefix)) - 1;
+	if((mask & start) != 0){
+		throw std::runtime_error(fmt::format("invalid [{:#0x}] mask and subnetip [{:#0x}] overlap on line {}",~mask,start,line));
+	}
+	return {start, start+mask};
 }
 auto parseIP(std::istream& in, int line) -> std::pair<uint32_t,uint32_t> {
 	uint32_t start = 0;
@@ -35,19 +79,6 @@ auto parseIP(std::istream& in, int line) -> std::pair<uint32_t,uint32_t> {
 	}
 	return {start,start};
 }
-void parseWhitespace(std::istream& in){
-	while(!in.eof()){
-		char next = in.peek();
-		switch(next){
-			case ' ':
-			case '\t':
-				in.get();
-				break;
-			default:
-				return;
-		}
-	}
-}
 auto parsePortList(std::string_view ports) -> std::vector<std::pair<uint16_t,uint16_t>> {
 	std::vector<std::pair<uint16_t,uint16_t>> ret;
 	for(auto port_config : util::split(ports,",")){
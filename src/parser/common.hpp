@@ -3,17 +3,24 @@
 #include <string>
 #include <string_view>
 #include <concepts>
+#include <charconv>
 
-void parseWhitespace(std::istream& in);
+/**
+ * reads "a.b.c.d" or "a.b.c.d/prefix" from the beginning of in without allocating\n
+ * like the istream version everything behind the address is ignored, e.g. ports
+ * @returns the first and last address of the network
+ * @throws std::runtime_error with the column of the first invalid character
+ */
 std::pair<uint32_t,uint32_t> parseIP(std::string_view in, int line = -1);
+//!reads the address with operator>>, only used to compare against the string_view version
 std::pair<uint32_t,uint32_t> parseIP(std::istream& in, int line = -1);
 std::vector<std::pair<uint16_t,uint16_t>> parsePortList(std::string_view ports);
 
 
+//!@returns the number at the beginning of sv, 0 if there is none
 template<typename integral>
 integral toInt(const std::string_view sv){
-	std::stringstream ss(sv.data());
-	integral i;
-	ss >> i;
+	integral i = 0;
+	std::from_chars(sv.data(),sv.data()+sv.size(),i);
 	return i;
 }
@@ -0,0 +1,42 @@
+#include <gtest/gtest.h>
+#include <rapidcheck/gtest.h>
+#include <sstream>
+#include <stdexcept>
+#include <fmt/format.h>
+#include "common.hpp"
+
+TEST(parseIP,addresses_and_networks){
+	EXPECT_EQ(parseIP("1.2.3.4"),(std::pair<uint32_t,uint32_t>{0x01020304,0x01020304}));
+	EXPECT_EQ(parseIP("10.0.0.0/8"),(std::pair<uint32_t,uint32_t>{0x0A000000,0x0AFFFFFF}));
+	EXPECT_EQ(parseIP("0.0.0.0/0"),(std::pair<uint32_t,uint32_t>{0,0xFFFFFFFF}));
+	EXPECT_EQ(parseIP("255.255.255.255/32"),(std::pair<uint32_t,uint32_t>{0xFFFFFFFF,0xFFFFFFFF}));
+	//ports behind the address are left to the caller
+	EXPECT_EQ(parseIP("1.2.3.4:80"),(std::pair<uint32_t,uint32_t>{0x01020304,0x01020304}));
+}
+TEST(parseIP,errors){
+	auto message = [](std::string_view ip){
+		try{
+			parseIP(ip,7);
+		}catch(const std::runtime_error& e){
+			return std::string{e.what()};
+		}
+		return std::string{};
+	};
+	EXPECT_EQ(message("1.2.3"),"invalid ip \"1.2.3\" on line 7: expected '.' at column 6");
+	EXPECT_EQ(message("1.2.256.4"),"invalid ip \"1.2.256.4\" on line 7: expected an octet up to 255 at column 5");
+	EXPECT_EQ(message("1.2.3.x"),"invalid ip \"1.2.3.x\" on line 7: expected a digit at column 7");
+	EXPECT_EQ(message("1.2.3.4/33"),"invalid ip \"1.2.3.4/33\" on line 7: expected a prefix length up to 32 at column 9");
+	EXPECT_EQ(message("1.2.3.1234"),"invalid ip \"1.2.3.1234\" on line 7: expected an octet up to 255 at column 7");
+	EXPECT_EQ(message("1.2.3.0/245"),"invalid ip \"1.2.3.0/245\" on line 7: expected a prefix length up to 32 at column 9");
+	EXPECT_EQ(message("1.2.3.4.5"),"invalid ip \"1.2.3.4.5\" on line 7: expected '/' or the end of the address at column 8");
+	EXPECT_EQ(message("0001.2.3.4"),"invalid ip \"0001.2.3.4\" on line 7: expected an octet up to 255 at column 1");
+	EXPECT_THROW(parseIP(""),std::runtime_error);
+	EXPECT_THROW(parseIP("1.2.3.4/24"),std::runtime_error);
+}
+RC_GTEST_PROP(parseIP,equal_to_istream,(uint32_t address, uint8_t prefix_seed)){
+	auto prefix = prefix_seed%32+1;
+	address &= ~static_cast<uint32_t>((uint64_t{1} << (32-prefix))-1);
+	auto ip = fmt::format("{}.{}.{}.{}/{}",address >> 24,(address >> 16)&0xFF,(address >> 8)&0xFF,address&0xFF,prefix);
+	std::stringstream in(ip);
+	RC_ASSERT(parseIP(ip) == parseIP(in));
+}
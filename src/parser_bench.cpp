@@ -0,0 +1,269 @@
+#include <benchmark/benchmark.h>
+#include "RulesetParser.hpp"
+#include "IpAnalyzer.hpp"
+#include "args.hpp"
+#include "parser/common.hpp"
+#include "snapshot.hpp"
+#include <filesystem>
+#include <sstream>
+#include <fmt/format.h>
+
+//!@returns an iptables-save table with rules spread over chains of 1000 rules
+static std::string generateTable(size_t rules, std::string_view name = "filter"){
+	std::string ret = fmt::format("*{}\n:INPUT DROP [0:0]\n:FORWARD DROP [0:0]\n:OUTPUT ACCEPT [0:0]\n",name);
+	for(size_t chain = 0; chain*1000 < rules; ++chain){
+		ret += fmt::format(":chain{} - [0:0]\n",chain);
+	}
+	for(size_t i = 0; i < rules; ++i){
+		size_t chain = i/1000;
+		if(i%1000 == 0){
+			ret += fmt::format("-A INPUT -s 10.{}.0.0/16 -j chain{}\n",chain%256,chain);
+			continue;
+		}
+		switch(i%4){
+			case 0:
+				ret += fmt::format("-A chain{} -s 10.{}.{}.{}/32 -d 192.168.{}.0/24 -p tcp -m tcp --dport {} -j ACCEPT\n",
+						chain,chain%256,i%256,(i/256)%256,i%256,i%65536);
+				break;
+			case 1:
+				ret += fmt::format("-A chain{} -i eth{} -p udp -m multiport --dports {},{}:{} -m comment --comment \"rule {}\" -j DROP\n",
+						chain,i%8,i%1024,1024+i%1024,2048+i%1024,i);
+				break;
+			case 2:
+				ret += fmt::format("-A chain{} ! -s 172.16.{}.0/24 -o eth{} -m conntrack --ctstate NEW -j REJECT\n",
+						chain,i%256,i%8);
+				break;
+			default:
+				ret += fmt::format("-A chain{} -d 10.{}.{}.{} -p tcp -m tcp --sport {} -j RETURN\n",
+						chain,chain%256,i%256,(i/256)%256,i%65536);
+		}
+	}
+	ret += "COMMIT\n";
+	return ret;
+}
+//!@returns an iptables-save dump of a filter table
+static std::string generateRuleset(size_t rules){
+	return "# Generated by iptables-save\n"+generateTable(rules);
+}
+static void BM_parseRuleset(benchmark::State& state){
+	auto text = generateRuleset(state.range(0));
+	for(auto _ : state){
+		std::istringstream in(text);
+		RulesetParser parser;
+		parser.parseRuleset(in);
+		auto ruleset = parser.releaseRuleset();
+		benchmark::DoNotOptimize(ruleset);
+	}
+	state.SetItemsProcessed(state.iterations()*state.range(0));
+	state.SetBytesProcessed(state.iterations()*text.size());
+}
+BENCHMARK(BM_parseRuleset)->Arg(10000)->Arg(500000)->Unit(benchmark::kMillisecond);
+//!like BM_parseRuleset without copying the stream into a buffer, as for memory mapped files
+static void BM_parseRulesetBuffer(benchmark::State& state){
+	auto text = generateRuleset(state.range(0));
+	for(auto _ : state){
+		RulesetParser parser;
+		parser.parseRulesetBuffer(text);
+		auto ruleset = parser.releaseRuleset();
+		benchmark::DoNotOptimize(ruleset);
+	}
+	state.SetItemsProcessed(state.iterations()*state.range(0));
+	state.SetBytesProcessed(state.iterations()*text.size());
+}
+BENCHMARK(BM_parseRulesetBuffer)->Arg(10000)->Arg(500000)->Unit(benchmark::kMillisecond);
+//!loads the snapshot of the ruleset parsed by BM_parseRulesetBuffer
+static void BM_loadSnapshot(benchmark::State& state){
+	auto path = (std::filesystem::temp_directory_path()/"fw-analyzer-bench.snapshot").string();
+	{
+		RulesetParser parser;
+		parser.parseRulesetBuffer(generateRuleset(state.range(0)));
+		parser.ruleset.forEachRule([](Rule& rule){
+					rule.maximumMatchingSet.canonicalize();
+				});
+		snapshot::write(path,0,parser.ruleset,parser.getInfo());
+	}
+	for(auto _ : state){
+		Ruleset ruleset;
+		parse_result_t info;
+		snapshot::load(path,0,ruleset,info);
+		benchmark::DoNotOptimize(ruleset);
+	}
+	std::filesystem::remove(path);
+	state.SetItemsProcessed(state.iterations()*state.range(0));
+}
+BENCHMARK(BM_loadSnapshot)->Arg(10000)->Arg(500000)->Unit(benchmark::kMillisecond);
+//!a dump of 4 equally large tables, parsed with 1 to 4 threads
+static void BM_parseRulesetTables(benchmark::State& state){
+	std::string text;
+	for(auto name : {"raw","mangle","nat","filter"}){
+		text += generateTable(125000,name);
+	}
+	for(auto _ : state){
+		args::threads = state.range(0);
+		RulesetParser parser;
+		parser.parseRulesetBuffer(text);
+		auto ruleset = parser.releaseRuleset();
+		benchmark::DoNotOptimize(ruleset);
+	}
+	args::threads = 1;
+	state.SetItemsProcessed(state.iterations()*500000);
+	state.SetBytesProcessed(state.iterations()*text.size());
+}
+BENCHMARK(BM_parseRulesetTables)->Arg(1)->Arg(4)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+//!@returns an ipset dump of a single hash:net set with entries alternating between hosts and /24 networks
+static std::string generateIpSet(size_t entries){
+	std::string ret = "create bench hash:net family inet hashsize 1024 maxelem 2000000\n";
+	for(size_t i = 0; i < entries; ++i){
+		auto address = static_cast<uint32_t>(i*2654435761u);
+		if(i%2){
+			ret += fmt::format("add bench {}.{}.{}.0/24\n",address >> 24,(address >> 16)&0xFF,(address >> 8)&0xFF);
+		}else{
+			ret += fmt::format("add bench {}.{}.{}.{}\n",address >> 24,(address >> 16)&0xFF,(address >> 8)&0xFF,address&0xFF);
+		}
+	}
+	return ret;
+}
+//!the addresses of a generated ipset dump
+static const std::vector<std::string>& ipSetAddresses(){
+	static const auto addresses = [](){
+		std::vector<std::string> ret;
+		std::istringstream in(generateIpSet(1000000));
+		std::string line;
+		std::getline(in,line);
+		while(std::getline(in,line)){
+			ret.push_back(line.substr(line.rfind(' ')+1));
+		}
+		return ret;
+	}();
+	return addresses;
+}
+static void BM_parseIP(benchmark::State& state){
+	const auto& addresses = ipSetAddresses();
+	for(auto _ : state){
+		for(const auto& address : addresses){
+			benchmark::DoNotOptimize(parseIP(std::string_view{address}));
+		}
+	}
+	state.SetItemsProcessed(state.iterations()*addresses.size());
+}
+BENCHMARK(BM_parseIP)->Unit(benchmark::kMillisecond);
+//!the previous implementation of parseIP(std::string_view), which copied the address into a stringstream
+static void BM_parseIP_stringstream(benchmark::State& state){
+	const auto& addresses = ipSetAddresses();
+	for(auto _ : state){
+		for(const auto& address : addresses){
+			std::stringstream in(address);
+			benchmark::DoNotOptimize(parseIP(in));
+		}
+	}
+	state.SetItemsProcessed(state.iterations()*addresses.size());
+}
+BENCHMARK(BM_parseIP_stringstream)->Unit(benchmark::kMillisecond);
+static void BM_parseIpSets(benchmark::State& state){
+	auto text = generateIpSet(1000000);
+	for(auto _ : state){
+		std::istringstream in(text);
+		RulesetParser parser;
+		parser.parseIpSets(in);
+		benchmark::DoNotOptimize(parser.ip_sets);
+	}
+	state.SetItemsProcessed(state.iterations()*1000000);
+	state.SetBytesProcessed(state.iterations()*text.size());
+}
+BENCHMARK(BM_parseIpSets)->Unit(benchmark::kMillisecond);
+//!@returns an ipset dump of a set of 10000 hash:net,port entries
+static std::string generatePortSet(){
+	std::string ret = "create ports hash:net,port family inet\n";
+	for(size_t i = 0; i < 10000; ++i){
+		ret += fmt::format("add ports 10.{}.{}.0/24,{}:{}\n",i/256,i%256,i%2 ? "udp" : "tcp",i%65536);
+	}
+	return ret;
+}
+//!@returns a table of 500 rules matching the set of generatePortSet, with and without restricting the source address first
+static std::string generatePortSetRules(){
+	std::string ret = "*filter\n:INPUT DROP [0:0]\n";
+	for(size_t i = 0; i < 500; ++i){
+		if(i%2){
+			ret += fmt::format("-A INPUT -s 10.{}.0.0/16 -m set --match-set ports src,dst -j ACCEPT\n",i%40);
+		}else{
+			ret += "-A INPUT -m set --match-set ports src,dst -j ACCEPT\n";
+		}
+	}
+	ret += "COMMIT\n";
+	return ret;
+}
+static void BM_parseRulesetWithIpSets(benchmark::State& state){
+	auto ipset = generatePortSet();
+	auto ruleset = generatePortSetRules();
+	for(auto _ : state){
+		RulesetParser parser;
+		std::istringstream in(ipset);
+		parser.parseIpSets(in);
+		parser.parseRulesetBuffer(ruleset);
+		auto result = parser.releaseRuleset();
+		benchmark::DoNotOptimize(result);
+	}
+	state.SetItemsProcessed(state.iterations()*500);
+}
+BENCHMARK(BM_parseRulesetWithIpSets)->Unit(benchmark::kMillisecond);
+//!prepares the rules of BM_parseRulesetWithIpSets for the analysis, canonicalizing sets of up to state.range(0) segments
+static void BM_constructAnalyzerWithIpSets(benchmark::State& state){
+	auto ipset = generatePortSet();
+	auto ruleset = generatePortSetRules();
+	args::config.canonicalize.max_segments = state.range(0);
+	for(auto _ : state){
+		//only the constructor is measured
+		state.PauseTiming();
+		RulesetParser parser;
+		std::istringstream in(ipset);
+		parser.parseIpSets(in);
+		parser.parseRulesetBuffer(ruleset);
+		auto result = parser.releaseRuleset();
+		state.ResumeTiming();
+		IpAnalyzer analyzer(std::move(result));
+		benchmark::DoNotOptimize(analyzer);
+	}
+	args::config.canonicalize = {};
+	state.SetItemsProcessed(state.iterations()*500);
+}
+BENCHMARK(BM_constructAnalyzerWithIpSets)->Arg(0)->Arg(1024)->Unit(benchmark::kMillisecond);
+//!@returns a table whose 50 chains are jumped to from INPUT, FORWARD and OUTPUT, which are piped with the same packets
+static std::string generateSharedChains(){
+	std::string ret = "*filter\n:INPUT DROP [0:0]\n:FORWARD DROP [0:0]\n:OUTPUT DROP [0:0]\n";
+	for(size_t chain = 0; chain < 50; ++chain){
+		ret += fmt::format(":svc{} - [0:0]\n",chain);
+	}
+	for(auto builtin : {"INPUT","FORWARD","OUTPUT"}){
+		for(size_t chain = 0; chain < 50; ++chain){
+			ret += fmt::format("-A {} -s 10.{}.0.0/16 -j svc{}\n",builtin,chain,chain);
+		}
+	}
+	for(size_t chain = 0; chain < 50; ++chain){
+		for(size_t i = 0; i < 200; ++i){
+			ret += fmt::format("-A svc{} -s 10.{}.{}.0/24 -p tcp -m tcp --dport {} -j ACCEPT\n",chain,chain,i,i);
+		}
+	}
+	ret += "COMMIT\n";
+	return ret;
+}
+/**
+ * the dead rule analysis with the pipe cache disabled and enabled\n
+ * range(0) selects a ruleset whose chains are piped several times or the one of BM_parseRuleset, whose chains are piped once
+ */
+static void BM_analyzeDeadRulesPipeCache(benchmark::State& state){
+	auto text = state.range(0) ? generateSharedChains() : generateRuleset(5000);
+	args::config.pipe_cache.enabled = state.range(1);
+	for(auto _ : state){
+		//only the analysis is measured
+		state.PauseTiming();
+		RulesetParser parser;
+		parser.parseRulesetBuffer(text);
+		IpAnalyzer analyzer(parser.releaseRuleset());
+		state.ResumeTiming();
+		analyzer.analyzeDeadRules();
+	}
+	args::config.pipe_cache = {};
+}
+BENCHMARK(BM_analyzeDeadRulesPipeCache)->ArgsProduct({{0,1},{0,1}})->Unit(benchmark::kMillisecond);
+BENCHMARK_MAIN();
@@ -0,0 +1,392 @@
+#include "snapshot.hpp"
+#include "args.hpp"
+#include "log.hpp"
+#include "util.hpp"
+#include <fmt/format.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <filesystem>
+#include <iterator>
+#include <limits>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+namespace snapshot {
+	static constexpr std::string_view magic{"fw-snap\0",8};
+	//!index of a missing jump target or of an empty set of flag segments
+	static constexpr uint32_t none = std::numeric_limits<uint32_t>::max();
+	//!magic, version, sizeof(PSegment), checksum and hash of the payload, keeps the segments of the payload aligned
+	static constexpr size_t header_bytes = 8+4+4+8+8;
+	static_assert(header_bytes%alignof(PSegment) == 0);
+	using flag_set_t = Rule::flag_segments_t::value_type;
+
+	/**
+	 * @brief FNV-1a over 8 byte words
+	 * @details not cryptographic, it only has to notice that a dump was changed
+	 */
+	class hasher {
+	public:
+		void add(std::string_view bytes){
+			size_t i = 0;
+			for(; i+8 <= bytes.size(); i += 8){
+				uint64_t word;
+				memcpy(&word,bytes.data()+i,8);
+				mix(word);
+			}
+			for(; i < bytes.size(); ++i)mix(static_cast<unsigned char>(bytes[i]));
+			//separates consecutive fields
+			mix(bytes.size());
+		}
+		auto value() const -> uint64_t {
+			return hash_m;
+		}
+	private:
+		void mix(uint64_t value){
+			hash_m = (hash_m^value)*0x100000001b3ull;
+		}
+		uint64_t hash_m = 0xcbf29ce484222325ull;
+	};
+
+	auto checksum(const std::vector<std::string>& files, std::vector<std::optional<std::string>>* texts) -> uint64_t {
+		hasher hash;
+		hash.add(args::nft ? "nft" : "iptables");
+		if(texts != nullptr){
+			texts->assign(files.size(),std::nullopt);
+		}
+		for(size_t i = 0; i < files.size(); ++i){
+			util::mapped_file file{files[i]};
+			if(file.good()){
+				hash.add(file.view());
+				continue;
+			}
+			std::ifstream in(files[i]);
+			if(!in.good()){
+				hash.add(files[i]);
+				continue;
+			}
+			std::string text{std::istreambuf_iterator<char>(in),std::istreambuf_iterator<char>()};
+			hash.add(text);
+			if(texts != nullptr){
+				(*texts)[i] = std::move(text);
+			}
+		}
+		//the configuration decides which rules are ignored and which rules without jump target are reported
+		auto addNames = [&hash](const std::set<std::string_view>& names){
+			hash.add(std::to_string(names.size()));
+			for(auto name : names)hash.add(name);
+		};
+		addNames(args::config.silence.no_jump_target);
+		addNames(args::config.disable.rules.with_jump_target);
+		hash.add(std::to_string(args::config.disable.rules.with_flags.size()));
+		for(const auto& [flag,arg] : args::config.disable.rules.with_flags){
+			hash.add(flag);
+			hash.add(arg ? "=" : "");
+			hash.add(arg.value_or(""));
+		}
+		return hash.value();
+	}
+
+	//!writes the fields of an image
+	class writer {
+	public:
+		explicit writer(std::ostream& out) : out_m(out) {}
+		template<typename T>
+		void put(const T& value){
+			static_assert(std::is_trivially_copyable_v<T>);
+			putBytes({reinterpret_cast<const char*>(&value),sizeof(T)});
+		}
+		void putString(std::string_view text){
+			put<uint32_t>(text.size());
+			putBytes(text);
+		}
+		void putBytes(std::string_view bytes){
+			out_m.write(bytes.data(),bytes.size());
+			pos_m += bytes.size();
+		}
+		//!pads the image, so the next field is aligned within the mapped file
+		void align(size_t alignment){
+			static constexpr char zeros[alignof(std::max_align_t)] = {};
+			putBytes({zeros,(alignment-pos_m%alignment)%alignment});
+		}
+	private:
+		std::ostream& out_m;
+		size_t pos_m = 0;
+	};
+	/**
+	 * @brief reads the fields of an image
+	 * @throws std::runtime_error if the image ends before a field
+	 */
+	class reader {
+	public:
+		explicit reader(std::string_view data) : data_m(data) {}
+		template<typename T>
+		auto get() -> T {
+			static_assert(std::is_trivially_copyable_v<T>);
+			T ret;
+			memcpy(&ret,getBytes(sizeof(T)).data(),sizeof(T));
+			return ret;
+		}
+		auto getString() -> std::string_view {
+			return getBytes(get<uint32_t>());
+		}
+		//!@returns a count of elements that occupy at least min_bytes each in the rest of the image
+		auto getCount(size_t min_bytes) -> size_t {
+			auto ret = get<uint64_t>();
+			if(ret > (data_m.size()-pos_m)/min_bytes)throw std::runtime_error("count beyond the end");
+			return ret;
+		}
+		//!@returns enum value that has to be at most max
+		template<typename T>
+		auto getEnum(T max) -> T {
+			auto ret = get<uint8_t>();
+			if(ret > static_cast<uint8_t>(max))throw std::runtime_error("invalid enum value");
+			return static_cast<T>(ret);
+		}
+		auto getBytes(size_t bytes) -> std::string_view {
+			if(bytes > data_m.size()-pos_m)throw std::runtime_error("truncated");
+			auto ret = data_m.substr(pos_m,bytes);
+			pos_m += bytes;
+			return ret;
+		}
+		void align(size_t alignment){
+			getBytes((alignment-pos_m%alignment)%alignment);
+		}
+		bool done() const {
+			return pos_m == data_m.size();
+		}
+	private:
+		std::string_view data_m;
+		size_t pos_m = 0;
+	};
+
+	//!writes everything behind the header
+	static void writePayload(writer& out, const Ruleset& ruleset, const parse_result_t& info){
+		out.put<uint64_t>(info.unknownFlags.size());
+		for(const auto& flag : info.unknownFlags)out.putString(flag);
+		out.put<uint64_t>(info.rulesWithoutJumpTarget.size());
+		for(auto line : info.rulesWithoutJumpTarget)out.put<uint64_t>(line);
+
+		//the flag segments of an ipset are shared by all rules matching it and stored once
+		std::unordered_map<const void*,uint32_t> flag_set_ids;
+		std::vector<const flag_set_t*> flag_sets;
+		std::unordered_map<const Chain*,std::pair<uint32_t,uint32_t>> chain_ids;
+		for(uint32_t t = 0; t < ruleset.tables.size(); ++t){
+			const auto& chains = ruleset.tables[t].chains;
+			for(uint32_t c = 0; c < chains.size(); ++c){
+				chain_ids.emplace(chains[c].get(),std::pair{t,c});
+				for(const auto& rule : chains[c]->rules){
+					for(const auto& set : rule.flag_segments){
+						if(set.identity() != nullptr && flag_set_ids.emplace(set.identity(),flag_sets.size()).second){
+							flag_sets.push_back(&set);
+						}
+					}
+				}
+			}
+		}
+		out.put<uint64_t>(flag_sets.size());
+		for(const auto* set : flag_sets){
+			out.put<uint64_t>(set->size());
+			for(const auto& [start,end] : *set){
+				out.put<uint32_t>(start);
+				out.put<uint32_t>(end);
+			}
+		}
+
+		//chains are declared before the rules, which refer to them by index
+		out.put<uint64_t>(ruleset.tables.size());
+		for(const auto& table : ruleset.tables){
+			out.putString(table.name);
+			out.put<uint64_t>(table.chains.size());
+			for(const auto& chain : table.chains){
+				out.putString(chain->name);
+				out.put<int32_t>(chain->line);
+				out.put<uint8_t>(static_cast<uint8_t>(chain->policy));
+				out.put<uint8_t>(static_cast<uint8_t>(chain->special));
+			}
+		}
+		for(const auto& table : ruleset.tables){
+			for(const auto& chain : table.chains){
+				out.put<uint64_t>(chain->rules.size());
+				for(const auto& rule : chain->rules){
+					out.put<int32_t>(rule.line);
+					out.putString(rule.line_str);
+					auto target = std::pair{none,none};
+					if(rule.jumpTarget != nullptr){
+						auto iter = chain_ids.find(rule.jumpTarget);
+						if(iter == chain_ids.end())throw std::runtime_error(fmt::format("jump target of line {} is not part of the ruleset",rule.line));
+						target = iter->second;
+					}
+					out.put<uint32_t>(target.first);
+					out.put<uint32_t>(target.second);
+					out.put<uint8_t>(static_cast<uint8_t>(rule.jumpType));
+					out.put<uint8_t>(rule.shouldBeIgnored);
+					out.put<uint8_t>(rule.nat.has_value());
+					if(rule.nat){
+						out.put<uint32_t>(rule.nat->start_ip);
+						out.put<uint32_t>(rule.nat->end_ip);
+						out.put<uint8_t>(rule.nat->has_port_change);
+						out.put<uint16_t>(rule.nat->start_port);
+						out.put<uint16_t>(rule.nat->end_port);
+					}
+					for(const auto& set : rule.flag_segments){
+						out.put<uint32_t>(set.identity() == nullptr ? none : flag_set_ids.at(set.identity()));
+					}
+					const auto& set = rule.maximumMatchingSet;
+					out.put<uint8_t>(set.isCanonical());
+					out.put<uint64_t>(set.segments.size());
+					out.align(alignof(PSegment));
+					out.putBytes({reinterpret_cast<const char*>(set.segments.data()),sizeof(PSegment)*set.segments.size()});
+				}
+			}
+		}
+	}
+	void write(const std::string& filename, uint64_t checksum, const Ruleset& ruleset, const parse_result_t& info){
+		//a run reading the snapshot concurrently sees either the old or the new file
+		auto temp = filename+".tmp";
+		try{
+			//the header holds the hash of the payload, so the payload is written first
+			std::ostringstream payload;
+			writer payload_out(payload);
+			writePayload(payload_out,ruleset,info);
+			hasher hash;
+			hash.add(payload.view());
+
+			std::ofstream file(temp,std::ios::binary|std::ios::trunc);
+			file.exceptions(std::ios::failbit|std::ios::badbit);
+			writer out(file);
+			out.putBytes(magic);
+			out.put<uint32_t>(version);
+			out.put<uint32_t>(sizeof(PSegment));
+			out.put<uint64_t>(checksum);
+			out.put<uint64_t>(hash.value());
+			out.putBytes(payload.view());
+			file.close();
+			std::filesystem::rename(temp,filename);
+		}catch(const std::exception& e){
+			std::error_code ignored;
+			std::filesystem::remove(temp,ignored);
+			mlog::warn("could not write snapshot \"{}\": {}\n",filename,e.what());
+			return;
+		}
+		mlog::success("wrote snapshot \"{}\"\n",filename);
+	}
+
+	static void readImage(reader& in, Ruleset& ruleset, parse_result_t& info){
+		for(auto count = in.getCount(4); count != 0; --count){
+			info.unknownFlags.emplace(in.getString());
+		}
+		for(auto count = in.getCount(8); count != 0; --count){
+			info.rulesWithoutJumpTarget.push_back(in.get<uint64_t>());
+		}
+
+		std::vector<flag_set_t> flag_sets(in.getCount(8));
+		std::vector<std::pair<uint32_t,uint32_t>> ranges;
+		for(auto& set : flag_sets){
+			ranges.resize(in.getCount(8));
+			for(auto& [start,end] : ranges){
+				start = in.get<uint32_t>();
+				end = in.get<uint32_t>();
+			}
+			set.insert(ranges.begin(),ranges.end());
+		}
+
+		//the rules refer to the names of their tables, which must not move anymore
+		ruleset.tables.resize(in.getCount(12));
+		for(auto& table : ruleset.tables){
+			table.name = in.getString();
+			table.chains.resize(in.getCount(10));
+			for(auto& chain : table.chains){
+				chain = std::make_unique<Chain>();
+				chain->name = in.getString();
+				chain->line = in.get<int32_t>();
+				chain->policy = in.getEnum(Chain::Policy::NONE);
+				chain->special = in.getEnum(Chain::Special::SNAT);
+			}
+		}
+		for(auto& table : ruleset.tables){
+			for(auto& chain : table.chains){
+				chain->rules.resize(in.getCount(32));
+				for(auto& rule : chain->rules){
+					rule.line = in.get<int32_t>();
+					rule.line_str = in.getString();
+					rule.table_name = table.name;
+					auto target_table = in.get<uint32_t>();
+					auto target_chain = in.get<uint32_t>();
+					if(target_table != none){
+						if(target_table >= ruleset.tables.size() || target_chain >= ruleset.tables[target_table].chains.size()){
+							throw std::runtime_error("jump target out of range");
+						}
+						rule.jumpTarget = ruleset.tables[target_table].chains[target_chain].get();
+					}
+					rule.jumpType = in.getEnum(JumpType::JUMP);
+					rule.shouldBeIgnored = in.get<uint8_t>();
+					if(in.get<uint8_t>()){
+						auto& nat = rule.nat.emplace();
+						nat.start_ip = in.get<uint32_t>();
+						nat.end_ip = in.get<uint32_t>();
+						nat.has_port_change = in.get<uint8_t>();
+						nat.start_port = in.get<uint16_t>();
+						nat.end_port = in.get<uint16_t>();
+					}
+					for(auto& set : rule.flag_segments){
+						auto id = in.get<uint32_t>();
+						if(id == none)continue;
+						if(id >= flag_sets.size())throw std::runtime_error("flag segments out of range");
+						set = flag_sets[id];
+					}
+					bool canonical = in.get<uint8_t>();
+					auto count = in.getCount(sizeof(PSegment));
+					in.align(alignof(PSegment));
+					auto bytes = in.getBytes(sizeof(PSegment)*count);
+					bor::vector<PSegment> segments(std::span{reinterpret_cast<const PSegment*>(bytes.data()),count});
+					if(std::ranges::any_of(std::as_const(segments),[](const PSegment& seg){ return seg.empty(); })){
+						throw std::runtime_error(fmt::format("empty segment in line {}",rule.line));
+					}
+					rule.maximumMatchingSet = canonical ? PSET::fromCanonical(std::move(segments)) : PSET(std::move(segments));
+				}
+			}
+		}
+	}
+	bool load(const std::string& filename, uint64_t checksum, Ruleset& ruleset, parse_result_t& info){
+		util::mapped_file file{filename};
+		if(!file.good())return false;
+		reader in(file.view());
+		try{
+			if(in.getBytes(magic.size()) != magic){
+				mlog::warn("\"{}\" is no snapshot, parsing again\n",filename);
+				return false;
+			}
+			if(in.get<uint32_t>() != version || in.get<uint32_t>() != sizeof(PSegment)){
+				mlog::info("snapshot \"{}\" was written by another version, parsing again\n",filename);
+				return false;
+			}
+			if(in.get<uint64_t>() != checksum){
+				mlog::info("snapshot \"{}\" is stale, parsing again\n",filename);
+				return false;
+			}
+			//the checksum only covers the dumps, a damaged payload could still be read
+			auto payload_hash = in.get<uint64_t>();
+			auto payload = file.view().substr(header_bytes);
+			hasher hash;
+			hash.add(payload);
+			if(hash.value() != payload_hash)throw std::runtime_error("payload doesn't match its hash");
+			reader payload_in(payload);
+			Ruleset loaded;
+			parse_result_t loaded_info;
+			readImage(payload_in,loaded,loaded_info);
+			if(!payload_in.done())throw std::runtime_error("trailing bytes");
+			ruleset = std::move(loaded);
+			info = std::move(loaded_info);
+		}catch(const std::runtime_error& e){
+			mlog::warn("snapshot \"{}\" is damaged ({}), parsing again\n",filename,e.what());
+			return false;
+		}
+		mlog::success("loaded snapshot \"{}\"\n",filename);
+		return true;
+	}
+}
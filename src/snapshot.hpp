@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Ruleset.hpp"
+#include "RulesetParser.hpp"
+
+/**
+ * @brief binary image of a parsed Ruleset, which is loaded instead of parsing the dump again
+ * @details the image holds the tables, chains and rules, jump targets as indices of chains\n
+ * and the maximumMatchingSets as flat arrays of canonical segments\n
+ * it is loaded from a memory mapped file, the segments are copied without decoding them\n
+ * every image records a checksum of the dumps it was parsed from and of the parts of\n
+ * args::config the parser applies, an image with another checksum is stale\n
+ * images are only read by the build that wrote them, the version and the layout\n
+ * of the segments are checked as well, a hash of the rest of the image detects damage
+ */
+namespace snapshot {
+	//!changes whenever the layout of the image changes
+	constexpr uint32_t version = 2;
+	/**
+	 * @param files the dumps the ruleset is parsed from, files that can't be opened only contribute their name
+	 * @param texts if given, receives the text of every file that can't be mapped, like a pipe,\n
+	 * which can only be read once and has to be parsed from this text, std::nullopt for the other files
+	 * @returns checksum of the files, the parser selected by args::nft and the parts of args::config the parser applies
+	 */
+	auto checksum(const std::vector<std::string>& files, std::vector<std::optional<std::string>>* texts = nullptr) -> uint64_t;
+	/**
+	 * writes the image of ruleset, whose maximumMatchingSets should be canonical\n
+	 * the file is replaced at once, a failure is logged and leaves it as it was
+	 */
+	void write(const std::string& filename, uint64_t checksum, const Ruleset& ruleset, const parse_result_t& info);
+	/**
+	 * replaces ruleset and info by the image in filename
+	 * @returns false if there is no image, if it is stale or can't be read, ruleset and info are left as they were then
+	 */
+	bool load(const std::string& filename, uint64_t checksum, Ruleset& ruleset, parse_result_t& info);
+}
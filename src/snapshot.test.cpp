@@ -0,0 +1,175 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <sys/stat.h>
+#include "snapshot.hpp"
+#include "RulesetParser.hpp"
+#include "args.hpp"
+
+namespace {
+	//!a ruleset with NAT, gotos, ipsets and ignored rules
+	void parseExample(RulesetParser& parser){
+		std::stringstream ipset(
+				"create hosts hash:net family inet\n"
+				"add hosts 10.0.0.1\n"
+				"add hosts 10.1.0.0/16\n");
+		std::string ruleset_text =
+			"*nat\n"
+			":PREROUTING ACCEPT [0:0]\n"
+			"-A PREROUTING -i eth0 -p tcp -m tcp --dport 80 -j DNAT --to-destination 1.2.3.4:8080\n"
+			"COMMIT\n"
+			"*filter\n"
+			":INPUT DROP [0:0]\n"
+			":hosts - [0:0]\n"
+			"-A INPUT -m set --match-set hosts src -g hosts\n"
+			"-A INPUT -m set --match-set hosts src -j hosts\n"
+			"-A INPUT -m conntrack --ctstate NEW -j ACCEPT\n"
+			"-A INPUT -s 192.168.0.0/16\n"
+			"-A hosts -p udp -j ACCEPT\n"
+			"COMMIT\n";
+		parser.parseIpSets(ipset);
+		parser.parseRulesetBuffer(ruleset_text);
+		//the analyzer can canonicalize the sets before writing the snapshot
+		parser.ruleset.forEachRule([](Rule& rule){
+					rule.maximumMatchingSet.canonicalize();
+				});
+	}
+	auto snapshotPath() -> std::string {
+		return (std::filesystem::temp_directory_path()/"fw-analyzer-snapshot.test").string();
+	}
+}
+
+TEST(snapshot,round_trip){
+	RulesetParser parser;
+	parseExample(parser);
+	auto path = snapshotPath();
+	snapshot::write(path,42,parser.ruleset,parser.getInfo());
+
+	Ruleset loaded;
+	parse_result_t info;
+	ASSERT_TRUE(snapshot::load(path,42,loaded,info));
+	std::filesystem::remove(path);
+
+	EXPECT_EQ(info.unknownFlags,parser.getInfo().unknownFlags);
+	EXPECT_EQ(info.rulesWithoutJumpTarget,parser.getInfo().rulesWithoutJumpTarget);
+	const auto& original = parser.ruleset;
+	ASSERT_EQ(loaded.tables.size(),original.tables.size());
+	for(size_t t = 0; t < loaded.tables.size(); ++t){
+		const auto& table = loaded.tables[t];
+		EXPECT_EQ(table.name,original.tables[t].name);
+		ASSERT_EQ(table.chains.size(),original.tables[t].chains.size());
+		for(size_t c = 0; c < table.chains.size(); ++c){
+			const auto& chain = *table.chains[c];
+			const auto& expected_chain = *original.tables[t].chains[c];
+			EXPECT_EQ(chain.name,expected_chain.name);
+			EXPECT_EQ(chain.line,expected_chain.line);
+			EXPECT_EQ(chain.policy,expected_chain.policy);
+			EXPECT_EQ(chain.special,expected_chain.special);
+			ASSERT_EQ(chain.rules.size(),expected_chain.rules.size());
+			for(size_t r = 0; r < chain.rules.size(); ++r){
+				const auto& rule = chain.rules[r];
+				const auto& expected = expected_chain.rules[r];
+				EXPECT_EQ(rule.line,expected.line);
+				EXPECT_EQ(rule.line_str,expected.line_str);
+				EXPECT_EQ(rule.table_name,table.name);
+				EXPECT_EQ(rule.jumpType,expected.jumpType);
+				EXPECT_EQ(rule.shouldBeIgnored,expected.shouldBeIgnored);
+				EXPECT_EQ(rule.nat,expected.nat);
+				EXPECT_EQ(rule.flag_segments,expected.flag_segments);
+				EXPECT_TRUE(rule.maximumMatchingSet.isCanonical());
+				EXPECT_EQ(rule.maximumMatchingSet,expected.maximumMatchingSet);
+				ASSERT_EQ(rule.jumpTarget == nullptr,expected.jumpTarget == nullptr);
+				if(rule.jumpTarget != nullptr){
+					//jump targets point into the loaded ruleset
+					EXPECT_EQ(rule.jumpTarget,loaded.findChain(table.name,expected.jumpTarget->name));
+				}
+			}
+		}
+	}
+	//both rules matching the ipset share its flag segments again
+	const auto& rules = loaded.findChain("filter","INPUT")->rules;
+	EXPECT_EQ(rules[0].flag_segments[Rule::SRC_IP].identity(),rules[1].flag_segments[Rule::SRC_IP].identity());
+	EXPECT_EQ(rules[0].flag_segments[Rule::SRC_IP].size(),2);
+}
+TEST(snapshot,stale_or_damaged_snapshots_are_not_loaded){
+	RulesetParser parser;
+	parseExample(parser);
+	auto path = snapshotPath();
+	Ruleset loaded;
+	parse_result_t info;
+	EXPECT_FALSE(snapshot::load(path+".missing",42,loaded,info));
+
+	snapshot::write(path,42,parser.ruleset,parser.getInfo());
+	EXPECT_FALSE(snapshot::load(path,43,loaded,info));
+	EXPECT_TRUE(loaded.tables.empty());
+
+	auto size = std::filesystem::file_size(path);
+	std::filesystem::resize_file(path,size-1);
+	EXPECT_FALSE(snapshot::load(path,42,loaded,info));
+	EXPECT_TRUE(loaded.tables.empty());
+	EXPECT_TRUE(info.unknownFlags.empty());
+
+	//a flipped bit anywhere behind the header is noticed, even if the image can still be read
+	snapshot::write(path,42,parser.ruleset,parser.getInfo());
+	{
+		std::fstream file(path,std::ios::binary|std::ios::in|std::ios::out);
+		file.seekg(-1,std::ios::end);
+		char last = file.get();
+		file.seekp(-1,std::ios::end);
+		file.put(last^1);
+	}
+	EXPECT_FALSE(snapshot::load(path,42,loaded,info));
+	EXPECT_TRUE(loaded.tables.empty());
+
+	//segments that contain no packets are never written by the analyzer
+	parser.ruleset.findChain("filter","INPUT")->rules.back().maximumMatchingSet.segments.push_back(PSegment(1,0));
+	snapshot::write(path,42,parser.ruleset,parser.getInfo());
+	EXPECT_FALSE(snapshot::load(path,42,loaded,info));
+	EXPECT_TRUE(loaded.tables.empty());
+
+	std::ofstream(path,std::ios::binary|std::ios::trunc) << "*filter\nCOMMIT\n";
+	EXPECT_FALSE(snapshot::load(path,42,loaded,info));
+	std::filesystem::remove(path);
+}
+TEST(snapshot,checksum_covers_dumps_and_parser_configuration){
+	auto path = snapshotPath()+".dump";
+	std::ofstream(path) << "*filter\n:INPUT DROP [0:0]\nCOMMIT\n";
+	auto checksum = snapshot::checksum({path});
+	EXPECT_EQ(snapshot::checksum({path}),checksum);
+
+	auto config = args::config;
+	//the analysis settings don't change the parsed ruleset
+	args::config.compaction.max_passes += 1;
+	EXPECT_EQ(snapshot::checksum({path}),checksum);
+	args::config.disable.rules.with_jump_target.insert("LOG");
+	EXPECT_NE(snapshot::checksum({path}),checksum);
+	args::config = config;
+
+	std::ofstream(path,std::ios::app) << "*nat\nCOMMIT\n";
+	EXPECT_NE(snapshot::checksum({path}),checksum);
+	std::filesystem::remove(path);
+}
+TEST(snapshot,checksum_keeps_the_text_of_pipes){
+	auto path = snapshotPath()+".fifo";
+	std::filesystem::remove(path);
+	ASSERT_EQ(mkfifo(path.c_str(),0600),0);
+	const std::string text = "*filter\n:INPUT DROP [0:0]\nCOMMIT\n";
+	std::thread writer([&](){
+		std::ofstream(path) << text;
+	});
+	std::vector<std::optional<std::string>> texts;
+	auto checksum = snapshot::checksum({path},&texts);
+	writer.join();
+	std::filesystem::remove(path);
+
+	//the pipe is hashed like a file with the same content
+	ASSERT_EQ(texts.size(),1);
+	ASSERT_TRUE(texts[0]);
+	EXPECT_EQ(*texts[0],text);
+	std::ofstream(path) << text;
+	EXPECT_EQ(snapshot::checksum({path},&texts),checksum);
+	EXPECT_FALSE(texts[0]);
+	std::filesystem::remove(path);
+}
@@ -0,0 +1,108 @@
+#include "spill.hpp"
+#include <atomic>
+#include <mutex>
+#include <unordered_set>
+#include <new>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+namespace spill {
+	static std::atomic<size_t> budget_m = 0;
+	static std::atomic<size_t> heap_bytes = 0;
+	static std::atomic<size_t> mapped_bytes = 0;
+	static std::atomic<size_t> peak_mapped_bytes = 0;
+	//mappings are large and rare, a set of them is cheaper than a header in front of every allocation
+	static std::mutex mappings_mutex;
+	static std::unordered_set<const void*> mappings;
+
+	void setBudget(size_t bytes){
+		budget_m = bytes;
+	}
+	size_t budget(){
+		return budget_m;
+	}
+	size_t heapBytes(){
+		return heap_bytes;
+	}
+	size_t mappedBytes(){
+		return mapped_bytes;
+	}
+	size_t peakMappedBytes(){
+		return peak_mapped_bytes;
+	}
+
+	static void* map(size_t bytes){
+		const char* dir = std::getenv("TMPDIR");
+		std::string path = std::string(dir != nullptr ? dir : "/tmp") + "/fw-analyzer-XXXXXX";
+		int fd = mkstemp(path.data());
+		if(fd == -1)throw std::bad_alloc();
+		unlink(path.c_str());
+		//reserving the blocks turns a full disk into an error here instead of SIGBUS on access
+		if(posix_fallocate(fd,0,bytes) != 0){
+			close(fd);
+			throw std::bad_alloc();
+		}
+		void* ptr = mmap(nullptr,bytes,PROT_READ|PROT_WRITE,MAP_SHARED,fd,0);
+		close(fd);
+		if(ptr == MAP_FAILED)throw std::bad_alloc();
+		return ptr;
+	}
+
+	void* allocate(size_t bytes){
+		size_t limit = budget_m;
+		if(limit != 0 && bytes >= min_mapped_bytes && heap_bytes+bytes > limit){
+			void* ptr = map(bytes);
+			{
+				std::lock_guard lock(mappings_mutex);
+				mappings.insert(ptr);
+			}
+			size_t total = mapped_bytes += bytes;
+			size_t peak = peak_mapped_bytes;
+			while(total > peak && !peak_mapped_bytes.compare_exchange_weak(peak,total));
+			return ptr;
+		}
+		void* ptr = std::malloc(std::max<size_t>(bytes,1));
+		if(ptr == nullptr)throw std::bad_alloc();
+		heap_bytes += bytes;
+		return ptr;
+	}
+	void deallocate(void* ptr, size_t bytes){
+		if(ptr == nullptr)return;
+		if(bytes >= min_mapped_bytes && mapped_bytes != 0){
+			std::lock_guard lock(mappings_mutex);
+			if(mappings.erase(ptr) != 0){
+				munmap(ptr,bytes);
+				mapped_bytes -= bytes;
+				return;
+			}
+		}
+		std::free(ptr);
+		heap_bytes -= bytes;
+	}
+	void* reallocate(void* ptr, size_t old_bytes, size_t new_bytes){
+		if(ptr == nullptr)return allocate(new_bytes);
+		size_t limit = budget_m;
+		bool map = limit != 0 && new_bytes >= min_mapped_bytes && heap_bytes-old_bytes+new_bytes > limit;
+		if(map || isMapped(ptr)){
+			void* ret = allocate(new_bytes);
+			memcpy(ret,ptr,std::min(old_bytes,new_bytes));
+			deallocate(ptr,old_bytes);
+			return ret;
+		}
+		void* ret = std::realloc(ptr,std::max<size_t>(new_bytes,1));
+		if(ret == nullptr)throw std::bad_alloc();
+		heap_bytes += new_bytes;
+		heap_bytes -= old_bytes;
+		return ret;
+	}
+	bool isMapped(const void* ptr){
+		if(mapped_bytes == 0)return false;
+		std::lock_guard lock(mappings_mutex);
+		return mappings.contains(ptr);
+	}
+}
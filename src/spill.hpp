@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+
+/**
+ * @brief backing storage of bor::vector with a bounded amount of RAM
+ * @details allocations are taken from the heap until the heap storage\n
+ * exceeds the budget, larger allocations past the budget are placed\n
+ * in memory mapped temporary files in $TMPDIR (or /tmp)\n
+ * the files are unlinked immediately, so they vanish with the mapping\n
+ * the disk space of a mapping is reserved up front, allocate throws\n
+ * std::bad_alloc if it can't be reserved instead of crashing on access\n
+ * without a budget every allocation is taken from the heap
+ */
+namespace spill {
+	//!allocations smaller than this are never mapped
+	constexpr size_t min_mapped_bytes = 64*1024;
+	/**
+	 * @param bytes amount of heap storage after which allocations are mapped, 0 disables mapping
+	 */
+	void setBudget(size_t bytes);
+	auto budget() -> size_t;
+	/**
+	 * @throws std::bad_alloc if neither heap nor disk can provide the storage
+	 */
+	auto allocate(size_t bytes) -> void*;
+	void deallocate(void* ptr, size_t bytes);
+	/**
+	 * resizes an allocation, heap storage is resized in place if possible\n
+	 * storage that crosses the budget is moved into a mapped file
+	 * @throws std::bad_alloc if neither heap nor disk can provide the storage
+	 */
+	auto reallocate(void* ptr, size_t old_bytes, size_t new_bytes) -> void*;
+	//!@returns whether ptr was returned by allocate and lives in a mapped file
+	bool isMapped(const void* ptr);
+	//!@returns bytes currently allocated on the heap
+	auto heapBytes() -> size_t;
+	//!@returns bytes currently held in mapped files
+	auto mappedBytes() -> size_t;
+	//!@returns largest amount of bytes held in mapped files at the same time
+	auto peakMappedBytes() -> size_t;
+}
@@ -1,4 +1,5 @@
 #include "try_parser.hpp"
+#include <algorithm>
 
 try_parser::try_parser(std::string_view input){
 	setInput(input);
@@ -18,13 +19,23 @@ void try_parser::pop(){
 	positions.pop();
 }
 void try_parser::nextLine(){
-	while(input[cur] != '\n')++cur;
-	++cur;
+	line();
+}
+std::string_view try_parser::line(){
+	size_t start = cur;
+	size_t end = input.find('\n',cur);
+	if(end == std::string_view::npos){
+		cur = input.size();
+		return input.substr(start);
+	}
+	cur = end+1;
+	return input.substr(start,end-start);
 }
 std::optional<int> try_parser::integer(){
 	int ret = 0;
 	bool negative = false;
 
+	if(done())return {};
 	if(input[cur] == '+'){
 		++cur;
 	}else if(input[cur] == '-'){
@@ -33,7 +44,7 @@ std::optional<int> try_parser::integer(){
 	}
 
 	bool nodigit = true;
-	while(input[cur] >= '0' && input[cur] <= '9' && cur < input.size()){
+	while(cur < input.size() && input[cur] >= '0' && input[cur] <= '9'){
 		nodigit = false;
 		ret *= 10;
 		ret += input[cur]-'0';
@@ -45,24 +56,27 @@ std::optional<int> try_parser::integer(){
 }
 std::string_view try_parser::string(){
 	size_t start = cur;
-	if(input[cur] == '\"'){
-		++cur;
-		while(input[cur] != '\"' && cur < input.size())++cur;
+	if(cur < input.size() && input[cur] == '\"'){
 		++cur;
+		while(cur < input.size() && input[cur] != '\"')++cur;
+		cur = std::min(cur+1,input.size());
 	}else{
-		while(input[cur] != ' ' && input[cur] != '\t' && input[cur] != '\n'  && cur < input.size())
+		while(cur < input.size() && input[cur] != ' ' && input[cur] != '\t' && input[cur] != '\n')
 			++cur;
 	}
-	return {&input[start],cur-start};
+	return input.substr(start,cur-start);
 }
 void try_parser::ws(){
-	while(input[cur] == ' ' || input[cur] == '\t' || input[cur] == '\n'){
+	while(cur < input.size() && (input[cur] == ' ' || input[cur] == '\t' || input[cur] == '\n')){
 		++cur;
 	}
 }
 bool try_parser::done(){
 	return cur >= input.size();
 }
+size_t try_parser::position() const {
+	return cur;
+}
 bool try_parser::matchStaticString(std::string_view pattern){
 	if(input.size()-cur < pattern.size())return false;
 
@@ -76,14 +90,13 @@ bool try_parser::matchStaticString(std::string_view pattern){
 	return true;
 }
 void try_parser::skip(size_t amount){
-	cur += amount;
+	cur = std::min(cur+amount,input.size());
 }
 std::optional<std::pair<std::string_view,std::string_view>> try_parser::until(std::string_view pattern){
 	auto str = std::string{pattern};
 	auto [regex_iter,b] = regex_cache.try_emplace(str,str);
-	std::smatch match;
-	const auto& c_input = input;
-	std::regex_search(c_input.begin()+cur,c_input.end(),match,regex_iter->second);
+	std::match_results<std::string_view::const_iterator> match;
+	std::regex_search(input.begin()+cur,input.end(),match,regex_iter->second);
 	if(match.empty()){
 		return {};
 	}else{
@@ -5,6 +5,10 @@
 #include <unordered_map>
 #include <regex>
 
+/**
+ * @brief reads tokens from a text without copying it
+ * @details the text has to outlive the parser and the returned string_views
+ */
 class try_parser {
 public:
 	try_parser(std::string_view);
@@ -13,6 +17,7 @@ public:
 	std::string_view string();//reads \"[^\"]\" or [^ ]+
 	void ws();//reads [ \t\n]
 	void nextLine();
+	std::string_view line();//reads [^\n]* and the following \n
 	void skip(size_t);
 	std::optional<int> integer();//reads [+-]\d+
 	std::optional<std::pair<std::string_view,std::string_view>> until(std::string_view pattern);
@@ -20,6 +25,7 @@ public:
 	bool matchStaticString(std::string_view); 
 
 	bool done();
+	size_t position() const;//offset of the next character in the input
 
 	void restore();
 	void save();
@@ -27,7 +33,7 @@ public:
 
 private:
 	std::unordered_map<std::string,std::regex> regex_cache;
-	std::string input;
+	std::string_view input;
 	std::stack<int> positions;
 	size_t cur;//current position in input
 };
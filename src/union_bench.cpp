@@ -31,6 +31,18 @@ static void BM_seq_UNION(benchmark::State& state){
 	benchmark::DoNotOptimize(lhs);
 	benchmark::DoNotOptimize(rhs);
 }
+//repeated unions into one growing set, like the accepted packets of a pipe run
+static void BM_seq_UNION_accumulate(benchmark::State& state){
+	for(auto _ : state){
+		PSET result;
+		for(int i = 0; i < state.range(0); ++i){
+			result.UNION_seq(rhs);
+		}
+		benchmark::DoNotOptimize(result);
+	}
+	benchmark::DoNotOptimize(rhs);
+}
 BENCHMARK(BM_seq_UNION);
+BENCHMARK(BM_seq_UNION_accumulate)->Arg(16)->Arg(256);
 BENCHMARK(BM_par_UNION)->DenseRange(1,8);
 BENCHMARK_MAIN();
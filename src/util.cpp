@@ -10,11 +10,41 @@
 #endif
 
 #include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
 
 namespace util {
 	auto isTTY() -> bool {
 		return ISATTY(FILENO(stdout));
 	}
+	mapped_file::mapped_file(const std::string& path){
+		//pipes and other special files report no size and can't be mapped,
+		//they aren't opened here, as a fifo loses its content when its last reader closes it
+		struct stat info;
+		if(stat(path.c_str(),&info) != 0 || !S_ISREG(info.st_mode))return;
+		int fd = open(path.c_str(),O_RDONLY);
+		if(fd < 0)return;
+		if(fstat(fd,&info) == 0 && S_ISREG(info.st_mode)){
+			size_m = info.st_size;
+			good_m = true;
+			//empty files can't be mapped
+			if(size_m != 0){
+				void* ptr = mmap(nullptr,size_m,PROT_READ,MAP_PRIVATE,fd,0);
+				if(ptr == MAP_FAILED){
+					size_m = 0;
+					good_m = false;
+				}else{
+					madvise(ptr,size_m,MADV_SEQUENTIAL);
+					data_m = static_cast<const char*>(ptr);
+				}
+			}
+		}
+		close(fd);
+	}
+	mapped_file::~mapped_file(){
+		if(data_m != nullptr)munmap(const_cast<char*>(data_m),size_m);
+	}
 	split_range::split_range(std::string_view sv, std::string_view delim) : 
 		text(sv),
 		delim(delim)
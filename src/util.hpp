@@ -3,30 +3,95 @@
 #include <iostream>
 #include <concepts>
 #include <unordered_map>
+#include <string>
+#include <string_view>
+#include <set>
+#include <memory>
+#include <algorithm>
 #include <fmt/core.h>
 
 namespace util {
+	/**
+	 * @brief hashes std::string and std::string_view alike\n
+	 * so maps keyed by std::string can be searched with string_views
+	 */
+	struct string_hash {
+		using is_transparent = void;
+		auto operator()(std::string_view text) const noexcept -> size_t {
+			return std::hash<std::string_view>{}(text);
+		}
+	};
+	/**
+	 * @brief std::set that is shared by its copies until one of them is modified
+	 * @details sets built once and copied to many owners, like the flag segments of an ipset,\n
+	 * are only stored once, modifying a shared copy copies it first
+	 */
+	template<typename T>
+	class cow_set {
+	public:
+		using set_t = std::set<T>;
+		using value_type = T;
+		using const_iterator = typename set_t::const_iterator;
+		using iterator = const_iterator;
+
+		auto begin() const -> const_iterator { return get().begin(); }
+		auto end() const -> const_iterator { return get().end(); }
+		auto size() const -> size_t { return get().size(); }
+		auto empty() const -> bool { return get().empty(); }
+		template<typename... Args>
+		auto emplace(Args&&... args){
+			return edit().emplace(std::forward<Args>(args)...);
+		}
+		template<typename Iter>
+		void insert(Iter first, Iter last){
+			edit().insert(first,last);
+		}
+		bool operator==(const cow_set& other) const {
+			return set_m == other.set_m || std::ranges::equal(get(),other.get());
+		}
+		//!@returns the same address for copies that weren't modified since, nullptr if nothing was inserted
+		auto identity() const -> const void* {
+			return set_m.get();
+		}
+	private:
+		auto get() const -> const set_t& {
+			static const set_t empty_set;
+			return set_m ? *set_m : empty_set;
+		}
+		auto edit() -> set_t& {
+			if(!set_m){
+				set_m = std::make_shared<set_t>();
+			}else if(set_m.use_count() > 1){
+				set_m = std::make_shared<set_t>(*set_m);
+			}
+			return *set_m;
+		}
+		std::shared_ptr<set_t> set_m;
+	};
 	/**
 	 * @brief maps inserted objects of type T to unique ids of type index_t
 	 */
 	template<typename T, typename index_t = uint8_t>
 	class indexer {
 	public:
-		auto getIndex(const T& t) -> index_t{
+		//!@param t is any type T can be constructed from and compared with, e.g. string_views for strings
+		template<typename K>
+		auto getIndex(const K& t) -> index_t{
 			auto iter = lookup.find(t);
 			if(iter != lookup.end())return iter->second;
 			else {
-				lookup[t] = lookup.size();
+				lookup.emplace(T(t),lookup.size());
 				return lookup.size()-1;
 			}
 		}
-		auto operator[](const T& t){
+		template<typename K>
+		auto operator[](const K& t){
 			return getIndex(t);
 		}
 	private:
-		std::unordered_map<T,index_t> lookup;
+		using hash_t = std::conditional_t<std::is_same_v<T,std::string>,string_hash,std::hash<T>>;
+		std::unordered_map<T,index_t,hash_t,std::equal_to<>> lookup;
 	};
-
 	/**
 	 * prints any Type T in its binary representation
 	 */
@@ -152,4 +217,29 @@ namespace util {
 	}
 
 	auto isTTY() -> bool;
+
+	/**
+	 * @brief read-only memory mapping of a whole file
+	 * @details the pages are loaded by the kernel on first access, nothing is copied
+	 */
+	class mapped_file {
+	public:
+		//!maps the file at path, good() is false if it can't be opened or isn't a regular file, like a pipe
+		explicit mapped_file(const std::string& path);
+		~mapped_file();
+		mapped_file(const mapped_file&) = delete;
+		mapped_file& operator=(const mapped_file&) = delete;
+
+		auto good() const -> bool {
+			return good_m;
+		}
+		//!@returns the content of the file, valid as long as this object
+		auto view() const -> std::string_view {
+			return {data_m,size_m};
+		}
+	private:
+		const char* data_m = nullptr;
+		size_t size_m = 0;
+		bool good_m = false;
+	};
 }
@@ -79,3 +79,17 @@ RC_GTEST_PROP(util,count_of_splits_equals_count_of_delimieter_plus_one,(const st
 	}
 	RC_ASSERT(commas + 1 == found);
 }
+TEST(util,cow_set_copies_on_modification){
+	util::cow_set<int> set1;
+	EXPECT_TRUE(set1.empty());
+	set1.emplace(1);
+	auto set2 = set1;
+	EXPECT_EQ(&*set1.begin(),&*set2.begin());
+	set2.emplace(2);
+	EXPECT_EQ(set1.size(),1);
+	EXPECT_EQ(set2.size(),2);
+	EXPECT_NE(set1,set2);
+	std::vector<int> values{2};
+	set1.insert(values.begin(),values.end());
+	EXPECT_EQ(set1,set2);
+}
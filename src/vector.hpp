@@ -3,77 +3,201 @@
 #include <ranges>
 #include <cstring>
 #include <cassert>
+#include <memory>
+#include <iterator>
+#include <functional>
+#include <type_traits>
+#include <atomic>
+#include <new>
+#include <algorithm>
+#include "memory_resource.hpp"
+#include "spill.hpp"
 
 namespace bor {
+	/**
+	 * @brief vector of elements taken from a memory_resource
+	 * @details copies share the storage of the original until either of them is modified,\n
+	 * every non-const access to the elements first gives the vector its own copy\n
+	 * so references into a vector must not be written through after it was copied\n
+	 * storage is only shared if it is taken from heap_resource() or from the resource\n
+	 * the copy would be allocated from, storage of other arenas doesn't live long enough
+	 */
 	template<typename T>
 	class vector {
 	private:
 		T* _data = nullptr;
 		size_t capacity_m = 0;
 		size_t length = 0;
+		memory_resource* resource_m = &default_resource();
+
+		/**
+		 * trivially copyable elements are kept in uninitialized storage\n
+		 * and relocated with reallocate/memcpy instead of element by element\n
+		 * other elements are default constructed for the whole capacity
+		 */
+		static constexpr bool relocatable = std::is_trivially_copyable_v<T>;
+
+		//!placed in front of the elements, the resource_m of the vectors sharing storage may differ
+		struct header_t {
+			std::atomic<size_t> references;
+			memory_resource* owner;
+		};
+		static_assert(alignof(T) <= alignof(std::max_align_t));
+		static constexpr size_t header_bytes = (sizeof(header_t)+alignof(T)-1)/alignof(T)*alignof(T);
+		static constexpr size_t storage_align = std::max(alignof(header_t),alignof(T));
+		static constexpr size_t storageBytes(size_t capacity){
+			return header_bytes+sizeof(T)*capacity;
+		}
+		auto storage() const -> char*{
+			return reinterpret_cast<char*>(_data)-header_bytes;
+		}
+		auto header() const -> header_t&{
+			return *std::launder(reinterpret_cast<header_t*>(storage()));
+		}
+		//!@returns whether other vectors reference _data as well
+		bool shared() const{
+			return _data != nullptr && header().references.load(std::memory_order_acquire) != 1;
+		}
+		//!@returns whether *this can reference the storage of other instead of copying it
+		bool shareable(const vector<T>& other) const{
+			if(other._data == nullptr)return false;
+			auto owner = other.header().owner;
+			return owner == &heap_resource() || owner == resource_m;
+		}
+		//!references the storage of other instead of _data, which has to be released
+		void share(const vector<T>& other){
+			other.header().references.fetch_add(1,std::memory_order_relaxed);
+			_data = other._data;
+			capacity_m = other.capacity_m;
+			length = other.length;
+			countCopy(true);
+		}
+
+		//!allocates size elements from resource_m
+		T* allocate(size_t size){
+			char* ptr = static_cast<char*>(resource_m->allocate(storageBytes(size),storage_align));
+			new (ptr) header_t{1,resource_m};
+			T* ret = reinterpret_cast<T*>(ptr+header_bytes);
+			if constexpr(!relocatable)std::uninitialized_default_construct_n(ret,size);
+			return ret;
+		}
+		//!drops the reference to _data, the last one destroys and frees it
+		void release(){
+			if(_data == nullptr)return;
+			auto& head = header();
+			//nobody else can take a new reference while this is the only one
+			if(head.references.load(std::memory_order_acquire) == 1 || head.references.fetch_sub(1,std::memory_order_acq_rel) == 1){
+				if constexpr(!relocatable)std::destroy_n(_data,capacity_m);
+				auto owner = head.owner;
+				head.~header_t();
+				owner->deallocate(storage(),storageBytes(capacity_m));
+			}
+			_data = nullptr;
+		}
+		template<typename ...Args>
+		void construct(T* ptr, Args&& ... args){
+			if constexpr(relocatable)new (ptr) T(std::forward<Args>(args)...);
+			else *ptr = T(std::forward<Args>(args)...);
+		}
+		//!copies size elements of source into target, which has space for them
+		static void copy(T* target, const T* source, size_t size){
+			if constexpr(relocatable){
+				if(size != 0)memcpy(target,source,sizeof(T)*size);
+			}else{
+				for(size_t i = 0; i < size; ++i)target[i] = source[i];
+			}
+		}
+		//!gives *this its own copy of shared storage before it is modified
+		void detach(){
+			if(!shared())return;
+			T* new_data = allocate(capacity_m);
+			copy(new_data,_data,length);
+			release();
+			_data = new_data;
+			countDetach();
+		}
 
-		template<bool init>
 		void grow(){
-			capacity_m *= 2;
-			if(capacity_m == 0)capacity_m = 8;
-			T* new_data;
-			/* if constexpr(init){ */
-				new_data = new T[capacity_m];
-			/* }else{ */
-			/* 	new_data = reinterpret_cast<T*>(malloc(sizeof(T) * capacity)); */
-			/* } */
-			/* memcpy(new_data,_data,sizeof(T)*length); */
-			for(size_t i = 0; i < length; ++i)new_data[i] = _data[i];
-			T* temp = _data;
+			reallocate(capacity_m == 0 ? 8 : capacity_m*2);
+		}
+		//!moves the elements into storage for new_capacity >= length elements
+		void reallocate(size_t new_capacity){
+			bool unique = !shared();
+			if constexpr(relocatable){
+				if(length != 0 && unique && header().owner == resource_m){
+					char* ptr = static_cast<char*>(resource_m->reallocate(storage(),storageBytes(capacity_m),storageBytes(new_capacity),storage_align));
+					_data = reinterpret_cast<T*>(ptr+header_bytes);
+					capacity_m = new_capacity;
+					return;
+				}
+			}
+			T* new_data = allocate(new_capacity);
+			if(relocatable || !unique){
+				copy(new_data,_data,length);
+			}else{
+				for(size_t i = 0; i < length; ++i)new_data[i] = std::move(_data[i]);
+			}
+			release();
 			_data = new_data;
-			if(temp != nullptr)delete[] temp;
+			capacity_m = new_capacity;
 		}
 	public:
 		using value_type = T;
 		using self_t = vector<T>;
 
 		vector() = default;
+		explicit vector(memory_resource& resource) : resource_m(&resource) {}
 		vector(std::initializer_list<T> list) {
 			if(std::empty(list))return;
-			/* _data = (T*)malloc(sizeof(T)*list.size()); */
-			_data = new T[list.size()];
+			_data = allocate(list.size());
 			capacity_m = list.size();
-			for(const auto& val : list)push_back(val);
+			for(const auto& val : list)construct(_data+length++,val);
 		}
 		vector(size_t size) {
 			resize(size);
 		}
-		vector(T* _data, size_t size) : _data(_data), length(size), capacity_m(size) {}
-
-		vector(bor::vector<T>&& other) : _data(other._data), capacity_m(other.capacity_m), length(other.length){
+		vector(bor::vector<T>&& other) : _data(other._data), capacity_m(other.capacity_m), length(other.length), resource_m(other.resource_m){
 			other._data = nullptr;
 			other.capacity_m = 0;
 			other.length = 0;
 		}
 		template<std::ranges::sized_range range>
 		vector(const range& other) : capacity_m(other.size()), length(other.size()){
-			_data = new T[capacity_m];
-			/* _data = (T*)malloc(sizeof(T)*other.length); */
-			/* memcpy(_data,other._data,sizeof(T)*length); */
-			for(size_t i = 0; i < length; ++i)_data[i] = other[i];
+			if(length == 0)return;
+			_data = allocate(capacity_m);
+			for(size_t i = 0; i < length; ++i)construct(_data+i,other[i]);
 		}
+		//!the copy belongs to default_resource(), not to the resource of other
 		vector(const vector<T>& other) : capacity_m(other.length), length(other.length){
-			_data = new T[capacity_m];
-			/* _data = (T*)malloc(sizeof(T)*other.length); */
-			/* memcpy(_data,other._data,sizeof(T)*length); */
-			for(size_t i = 0; i < length; ++i)_data[i] = other[i];
+			if(length == 0)return;
+			if(shareable(other)){
+				share(other);
+				return;
+			}
+			_data = allocate(capacity_m);
+			copy(_data,other._data,length);
+			countCopy(false);
 		}
 		~vector(){
-			if(_data != nullptr)delete[] _data;
+			release();
 		}
 		void push_back(const T& t){
-			if(length == capacity_m)grow<false>();
-			_data[length++] = t;
+			emplace_back(t);
+		}
+		void push_back(T&& t){
+			emplace_back(std::move(t));
 		}
 		template<typename ...Args>
-		void emplace_back(Args ... args){
-			if(length == capacity_m)grow<false>();
-			_data[length++] = T(std::forward<Args>(args)...);
+		void emplace_back(Args&& ... args){
+			if(length == capacity_m || shared()){
+				//the arguments may refer to elements that are relocated by grow or detach
+				T value(std::forward<Args>(args)...);
+				if(length == capacity_m)grow();
+				else detach();
+				construct(_data+length++,std::move(value));
+				return;
+			}
+			construct(_data+length++,std::forward<Args>(args)...);
 		}
 
 		size_t capacity() const{
@@ -88,6 +212,7 @@ namespace bor {
 		}
 		T& operator[](size_t index) {
 			assert(index < length);
+			detach();
 			return _data[index];
 		}
 
@@ -99,40 +224,72 @@ namespace bor {
 			}
 			return true;
 		}
-		auto begin() const{
+		auto begin() const -> const T*{
 			return _data;
 		}
-		auto end() const{
+		auto end() const -> const T*{
 			return _data+length;
 		}
-		auto begin(){
+		auto begin() -> T*{
+			detach();
 			return _data;
 		}
-		auto end(){
+		auto end() -> T*{
+			detach();
 			return _data+length;
 		}
 		void reserve(size_t size){
 			if(capacity_m < size){
-				capacity_m = size/2+1;
-				grow<false>();
+				reallocate((size/2+1)*2);
+			}
+		}
+		//!reduces the capacity to the size, shared storage is left as is
+		void shrink_to_fit(){
+			if(capacity_m == length)return;
+			if(length == 0){
+				release();
+				capacity_m = 0;
+				return;
 			}
+			if(shared())return;
+			reallocate(length);
+		}
+		//!@returns whether the elements are stored in a mapped file
+		bool mapped() const{
+			return _data != nullptr && spill::isMapped(storage());
+		}
+		//!@returns whether the elements are shared with copies of the vector
+		bool sharesStorage() const{
+			return shared();
+		}
+		auto resource() const -> memory_resource&{
+			return *resource_m;
 		}
 		void clear(){
 			length = 0;
 		}
+		//!new elements are left uninitialized if T is trivially copyable
 		void resize_no_init(size_t size){
 			reserve(size);
+			detach();
 			length = size;
 		}
+		//!new elements are value initialized
 		void resize(size_t size){
-			if(capacity_m < size){
-				capacity_m = size/2+1;
-				grow<true>();
+			reserve(size);
+			detach();
+			if(size > length){
+				if constexpr(relocatable)std::uninitialized_value_construct_n(_data+length,size-length);
+				else std::fill(_data+length,_data+size,T());
 			}
 			length = size;
 		}
+		//!storage can't be handed between resources, then the elements are copied into the own one
 		self_t& operator=(self_t&& other){
-			if(_data != nullptr)delete[] _data;
+			if(resource_m != other.resource_m){
+				return *this = other;
+			}
+			release();
 			_data = other._data;
 			length = other.length;
 			capacity_m = other.capacity_m;
@@ -142,15 +299,27 @@ namespace bor {
 			return *this;
 		}
 		self_t& operator=(const self_t& other){
-			if(capacity_m < other.size()){
-				delete[] _data;
-				_data = new T[other.size()];
-				capacity_m = other.size();
+			if(this == &other)return *this;
+			if(_data != nullptr && _data == other._data){
+				length = other.length;
+				return *this;
 			}
-			length = other.size();
-			for(size_t i = 0; i < other.size(); ++i){
-				_data[i] = other[i];
+			if(other.length != 0 && shareable(other)){
+				release();
+				share(other);
+				return *this;
+			}
+			if(capacity_m < other.size() || shared()){
+				release();
+				capacity_m = 0;
+				if(other.size() != 0){
+					_data = allocate(other.size());
+					capacity_m = other.size();
+				}
 			}
+			length = other.size();
+			copy(_data,other._data,length);
+			if(length != 0)countCopy(false);
 			return *this;
 		}
 		bool empty() const {
@@ -166,15 +335,34 @@ namespace bor {
 		}
 		value_type& back(){
 			assert(length != 0);
+			detach();
 			return _data[length-1];
 		}
-		const auto data() const{
+		auto data() const -> const T*{
 			return _data;
 		}
-		auto data(){
+		auto data() -> T*{
+			detach();
 			return _data;
 		}
-		void insert_back(auto start, auto end){
+		template<typename iterator>
+		void insert_back(iterator start, iterator end){
+			if constexpr(relocatable && std::contiguous_iterator<iterator> && std::is_same_v<std::iter_value_t<iterator>,T>){
+				size_t count = end-start;
+				const T* source = std::to_address(start);
+				//the source may be part of the storage that is relocated
+				bool own = std::less_equal<const T*>{}(_data,source) && std::less<const T*>{}(source,_data+length);
+				size_t offset = own ? source-_data : 0;
+				if(length+count > capacity_m){
+					reallocate(std::max(length+count,capacity_m*2));
+				}else{
+					detach();
+				}
+				if(own)source = _data+offset;
+				if(count != 0)memcpy(_data+length,source,sizeof(T)*count);
+				length += count;
+				return;
+			}
 			while(start != end){
 				push_back(*start);
 				++start;
@@ -111,3 +111,169 @@
 /* 	cpy.push_back(val2); */
 /* 	RC_ASSERT(vec != cpy); */
 /* } */
+TEST(vector,spills_past_budget){
+	spill::setBudget(1);
+	{
+		bor::vector<PSegment> vec;
+		for(uint32_t i = 0; i < 10000; ++i){
+			vec.emplace_back(i,i);
+		}
+		EXPECT_TRUE(vec.mapped());
+		EXPECT_GE(spill::mappedBytes(),sizeof(PSegment)*vec.size());
+		bor::vector<PSegment> cpy = vec;
+		for(uint32_t i = 0; i < 10000; ++i){
+			ASSERT_EQ(cpy[i],PSegment(i,i));
+		}
+		bor::vector<int> small = {1,2,3};
+		EXPECT_FALSE(small.mapped());
+	}
+	EXPECT_EQ(spill::mappedBytes(),0);
+	spill::setBudget(0);
+}
+TEST(vector,spill_failure_throws_bad_alloc){
+	const char* prev = std::getenv("TMPDIR");
+	std::string prev_dir = prev != nullptr ? prev : "";
+	setenv("TMPDIR","/nonexistent/fw-analyzer",1);
+	spill::setBudget(1);
+	bor::vector<PSegment> vec;
+	EXPECT_THROW(vec.resize(100000),std::bad_alloc);
+	spill::setBudget(0);
+	if(prev != nullptr)setenv("TMPDIR",prev_dir.c_str(),1);
+	else unsetenv("TMPDIR");
+}
+TEST(vector,arena_reuses_storage_after_reset){
+	bor::arena arena(1024);
+	auto fill = [&](){
+		bor::resource_scope scope(arena);
+		bor::vector<PSegment> vec;
+		for(uint32_t i = 0; i < 1000; ++i){
+			vec.emplace_back(i,i);
+		}
+		EXPECT_EQ(&vec.resource(),&arena);
+		EXPECT_EQ(vec[999],PSegment(999,999));
+	};
+	fill();
+	arena.reset();
+	auto chunks = bor::allocationStats().arena_chunks;
+	auto capacity = arena.capacity();
+	for(int i = 0; i < 10; ++i){
+		fill();
+		arena.reset();
+	}
+	EXPECT_EQ(bor::allocationStats().arena_chunks,chunks);
+	EXPECT_EQ(arena.capacity(),capacity);
+}
+TEST(vector,move_between_resources_copies){
+	bor::vector<int> heap = {1,2,3};
+	bor::arena arena;
+	bor::vector<int> temp(arena);
+	temp.push_back(4);
+	temp.push_back(5);
+	heap = std::move(temp);
+	arena.reset();
+	EXPECT_EQ(&heap.resource(),&bor::heap_resource());
+	EXPECT_EQ(heap,(bor::vector<int>{4,5}));
+	bor::vector<int> moved(std::move(heap));
+	EXPECT_EQ(moved,(bor::vector<int>{4,5}));
+}
+TEST(vector,push_back_own_element_while_growing){
+	bor::vector<PSegment> vec;
+	vec.emplace_back(1,2);
+	while(vec.size() != vec.capacity())vec.push_back(vec.back());
+	vec.push_back(vec[0]);
+	vec.insert_back(vec.begin(),vec.end());
+	for(const auto& seg : vec){
+		ASSERT_EQ(seg,PSegment(1,2));
+	}
+}
+TEST(vector,shrink_to_fit_keeps_elements){
+	bor::vector<PSegment> vec;
+	for(uint32_t i = 0; i < 100; ++i)vec.emplace_back(i,i);
+	vec.resize(10);
+	vec.shrink_to_fit();
+	EXPECT_EQ(vec.capacity(),10);
+	for(uint32_t i = 0; i < 10; ++i){
+		ASSERT_EQ(vec[i],PSegment(i,i));
+	}
+	vec.clear();
+	vec.shrink_to_fit();
+	EXPECT_EQ(vec.capacity(),0);
+	EXPECT_EQ(vec.data(),nullptr);
+}
+TEST(vector,resize_constructs_new_elements){
+	bor::vector<PSegment> vec;
+	vec.emplace_back(1,2);
+	vec.clear();
+	vec.resize(3);
+	for(const auto& seg : vec){
+		ASSERT_EQ(seg,PSegment());
+	}
+}
+TEST(vector,copies_share_storage_until_modified){
+	bor::vector<PSegment> vec;
+	for(uint32_t i = 0; i < 10; ++i)vec.emplace_back(i,i);
+	auto before = bor::allocationStats();
+	auto copy = vec;
+	EXPECT_TRUE(copy.sharesStorage());
+	EXPECT_EQ(std::as_const(copy).data(),std::as_const(vec).data());
+	EXPECT_EQ(bor::allocationStats().shared_copies,before.shared_copies+1);
+	EXPECT_EQ(bor::allocationStats().element_copies,before.element_copies);
+
+	copy[0] = PSegment(42,42);
+	EXPECT_FALSE(copy.sharesStorage());
+	EXPECT_FALSE(vec.sharesStorage());
+	EXPECT_EQ(bor::allocationStats().detached_copies,before.detached_copies+1);
+	EXPECT_EQ(vec[0],PSegment(0,0));
+	EXPECT_EQ(copy[0],PSegment(42,42));
+	EXPECT_EQ(copy[9],PSegment(9,9));
+
+	bor::vector<PSegment> assigned;
+	assigned = vec;
+	assigned.push_back(PSegment(10,10));
+	vec.pop_back();
+	vec.push_back(PSegment(11,11));
+	EXPECT_EQ(assigned.size(),11);
+	EXPECT_EQ(assigned[9],PSegment(9,9));
+	EXPECT_EQ(vec[9],PSegment(11,11));
+}
+TEST(vector,copies_of_arena_storage){
+	bor::arena arena;
+	bor::vector<PSegment> temp(arena);
+	temp.emplace_back(1,2);
+	//the copy outlives the arena
+	bor::vector<PSegment> heap = temp;
+	EXPECT_FALSE(heap.sharesStorage());
+	{
+		bor::resource_scope scope(arena);
+		bor::vector<PSegment> copy = temp;
+		EXPECT_TRUE(copy.sharesStorage());
+	}
+	arena.reset();
+	EXPECT_EQ(heap[0],PSegment(1,2));
+}
+RC_GTEST_PROP(vector,copies_are_independent,(const std::vector<PSegment>& elements, const PSegment& extra)){
+	bor::vector<PSegment> vec(elements);
+	auto copy = vec;
+	auto copy2 = copy;
+	copy.push_back(extra);
+	if(!copy2.empty())copy2[0] = extra;
+	RC_ASSERT(vec == elements);
+	RC_ASSERT(copy.size() == elements.size()+1);
+	RC_ASSERT(copy.back() == extra);
+	copy.pop_back();
+	RC_ASSERT(copy == elements);
+}
+TEST(vector,set_operations_on_copies_keep_the_original){
+	PSegment seg1, seg2;
+	seg1.setInterval<PSegment::DST_PORT_INDEX>(10,19);
+	seg2.setInterval<PSegment::DST_PORT_INDEX>(15,25);
+	PSET set{{seg1}}, other{{seg2}};
+	auto before = bor::allocationStats();
+	auto intersection = INTERSECTION(set,other);
+	//the operand is read from the shared storage and replaced by the result
+	EXPECT_EQ(bor::allocationStats().detached_copies,before.detached_copies);
+	EXPECT_EQ(bor::allocationStats().element_copies,before.element_copies);
+	EXPECT_EQ(set.segments[0],seg1);
+	EXPECT_EQ(intersection.segments.size(),1);
+	EXPECT_EQ(intersection.segments[0].getStart<PSegment::DST_PORT_INDEX>(),15);
+}